@@ -0,0 +1,68 @@
+//----------------------------------------------------------------------------
+//	RootNode - bitmask gate bank for the gate benchmark
+//	Several groups of four gates through TGateProcessor per call, with
+//	states and edges returned as bitmasks. The module keeps its gates in
+//	TGateProcessor directly, one per VCO and one for CLOCK.
+//----------------------------------------------------------------------------
+#pragma once
+#include <cstdint>
+#include "inc/GateProcessor.hpp"
+
+// GROUPS groups of four gates, set together from 4 * GROUPS consecutive values. States
+// and edges are bitmasks with gate i in bit i, so a caller can skip work with a single
+// test when no gate has moved. Up to 32 gates fit the masks
+template <int GROUPS>
+class GateBank {
+	static_assert(GROUPS >= 1 && GROUPS <= 8, "GateBank masks hold 1 to 32 gates");
+
+	private:
+		TGateProcessor<simd::float_4> groups[GROUPS];
+		uint32_t prevBits = 0;
+		uint32_t currentBits = 0;
+
+	public:
+		static const int GATES = 4 * GROUPS;
+		// shifted by half twice, as a 32 bit shift of 32 gates is undefined
+		static const uint32_t ALL = (((uint32_t) 1 << (GATES / 2)) << (GATES - GATES / 2)) - 1;
+
+		// set the gates with the given values, returns the gates that are high
+		uint32_t set(const float* values) {
+			prevBits = currentBits;
+			currentBits = 0;
+			for (int g = 0; g < GROUPS; g++)
+				currentBits |= (uint32_t) simd::movemask(groups[g].set(simd::float_4::load(values + 4 * g))) << (4 * g);
+			return currentBits;
+		}
+
+		// reset the gate processors
+		void reset() {
+			for (int g = 0; g < GROUPS; g++)
+				groups[g].reset();
+			prevBits = currentBits = 0;
+		}
+
+		// gates that are high
+		uint32_t high() const {
+			return currentBits;
+		}
+
+		// gates that are low
+		uint32_t low() const {
+			return ~currentBits & ALL;
+		}
+
+		// gates that had a leading edge on the latest values
+		uint32_t leadingEdges() const {
+			return currentBits & ~prevBits;
+		}
+
+		// gates that had a trailing edge on the latest values
+		uint32_t trailingEdges() const {
+			return prevBits & ~currentBits;
+		}
+
+		// gates that had any edge on the latest values
+		uint32_t anyEdges() const {
+			return prevBits ^ currentBits;
+		}
+};
@@ -0,0 +1,137 @@
+//----------------------------------------------------------------------------
+//	RootNode - gate processor microbenchmark
+//	Runs eight gates through the scalar GateProcessor, TGateProcessor on
+//	simd::float_4 lane masks and GateBank bitmasks, four and eight gates per
+//	call, and reports ns per gate sample and the speedup over the scalar
+//	version. Every version must count the same leading and trailing edges.
+//
+//	usage: gate_bench [samples]
+//----------------------------------------------------------------------------
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include <rack.hpp>
+
+using namespace rack;
+using simd::float_4;
+
+#include "GateBank.hpp"
+
+static const int GATES = 8;
+
+struct Edges {
+	long leading = 0;
+	long trailing = 0;
+
+	bool operator==(const Edges& other) const {
+		return leading == other.leading && trailing == other.trailing;
+	}
+};
+
+// Pulses with a different period per gate, plus noise that often lands between the
+// thresholds so the hysteresis is exercised. Values stay off the thresholds
+// themselves, where the scalar version's rescale can round the other way
+static std::vector<float> buildGates(long samples) {
+	std::vector<float> values(samples * GATES);
+	uint32_t seed = 1;
+	for (long i = 0; i < samples; i++) {
+		for (int g = 0; g < GATES; g++) {
+			seed = seed * 1664525u + 1013904223u;
+			float noise = (seed >> 8) * (1.f / 16777216.f);
+			bool high = (i / (3 + 2 * g)) % 2;
+			values[i * GATES + g] = (high ? 3.03f : -0.97f) + 2.5f * (noise - 0.5f);
+		}
+	}
+	return values;
+}
+
+static int popcount(uint32_t x) {
+	return __builtin_popcount(x);
+}
+
+static Edges runScalar(const std::vector<float>& values, long samples) {
+	GateProcessor gates[GATES];
+	Edges edges;
+	for (long i = 0; i < samples; i++) {
+		for (int g = 0; g < GATES; g++) {
+			gates[g].set(values[i * GATES + g]);
+			edges.leading += gates[g].leadingEdge();
+			edges.trailing += gates[g].trailingEdge();
+		}
+	}
+	return edges;
+}
+
+static Edges runLanes(const std::vector<float>& values, long samples) {
+	TGateProcessor<float_4> gates[GATES / 4];
+	Edges edges;
+	for (long i = 0; i < samples; i++) {
+		for (int g = 0; g < GATES / 4; g++) {
+			gates[g].set(float_4::load(&values[i * GATES + 4 * g]));
+			edges.leading += popcount(simd::movemask(gates[g].leadingEdge()));
+			edges.trailing += popcount(simd::movemask(gates[g].trailingEdge()));
+		}
+	}
+	return edges;
+}
+
+template <int GROUPS>
+static Edges runBank(const std::vector<float>& values, long samples) {
+	GateBank<GROUPS> banks[GATES / (4 * GROUPS)];
+	Edges edges;
+	for (long i = 0; i < samples; i++) {
+		for (int b = 0; b < GATES / (4 * GROUPS); b++) {
+			banks[b].set(&values[i * GATES + 4 * GROUPS * b]);
+			// most samples have no edge, one test covers every gate in the bank
+			uint32_t moved = banks[b].anyEdges();
+			if (moved) {
+				edges.leading += popcount(banks[b].leadingEdges());
+				edges.trailing += popcount(banks[b].trailingEdges());
+			}
+		}
+	}
+	return edges;
+}
+
+template <typename F>
+static double nsPerGateSample(F f, long samples, Edges& edges) {
+	auto start = std::chrono::steady_clock::now();
+	edges = f();
+	auto end = std::chrono::steady_clock::now();
+	return std::chrono::duration<double, std::nano>(end - start).count() / samples / GATES;
+}
+
+int main(int argc, char** argv) {
+	long samples = argc > 1 ? std::atol(argv[1]) : 4000000;
+	std::vector<float> values = buildGates(samples);
+
+	std::printf("%d gates, %ld samples\n", GATES, samples);
+	std::printf("%-26s %10s %10s %10s %10s\n", "version", "ns/gate", "speedup", "leading", "trailing");
+
+	Edges reference;
+	double base = nsPerGateSample([&] { return runScalar(values, samples); }, samples, reference);
+	std::printf("%-26s %10.2f %9.2fx %10ld %10ld\n", "GateProcessor", base, 1.0, reference.leading, reference.trailing);
+
+	struct Version {
+		const char* name;
+		Edges (*run)(const std::vector<float>&, long);
+	};
+	const Version versions[] = {
+		{"TGateProcessor<float_4>", runLanes},
+		{"GateBank<1>, 4 per call", runBank<1>},
+		{"GateBank<2>, 8 per call", runBank<2>},
+	};
+
+	bool match = true;
+	for (const Version& version : versions) {
+		Edges edges;
+		double ns = nsPerGateSample([&] { return version.run(values, samples); }, samples, edges);
+		std::printf("%-26s %10.2f %9.2fx %10ld %10ld\n", version.name, ns, base / ns, edges.leading, edges.trailing);
+		match = match && edges == reference;
+	}
+
+	if (!match)
+		std::printf("edge counts differ from GateProcessor\n");
+	return match ? 0 : 1;
+}
@@ -0,0 +1,707 @@
+//----------------------------------------------------------------------------
+//	RootNode - headless SubharmonicGenerator benchmark
+//	Drives SubharmonicGenerator::process() against the Rack stub for every
+//	sample rate, waveform, quantize mode and input connection combination,
+//	and reports ns/sample and samples/sec for each, then times each waveform
+//	with only some of the outputs patched, with audio rate FM, with hard
+//	sync and in rhythm mode, times wavetable saws against minBLEP saws,
+//	times the mix bus options, times unison stacks against as many separate
+//	modules, times publishing the voice state to an expander, times the
+//	panel scope's tap, times many modules sharing the cache, and checks the
+//	built in profiler against the wall clock. Heap allocations made inside
+//	process() are counted and fail the run, as do a voice bus message that
+//	is not from the sample before, a scope frame lost on its way to the UI
+//	thread and a profiled call from before a reset.
+//
+//	usage: module_bench [frames per case] [channels]
+//----------------------------------------------------------------------------
+#include <chrono>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <vector>
+#include "SubharmonicGenerator.hpp"
+
+// count every operator new made while a case is being timed. The replacements
+// forward to malloc/free, which gcc would otherwise flag as mismatched.
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+static bool countAllocations = false;
+static long allocations = 0;
+
+void* operator new(size_t size) {
+	if (countAllocations)
+		allocations++;
+	void* p = std::malloc(size ? size : 1);
+	if (!p)
+		throw std::bad_alloc();
+	return p;
+}
+
+void* operator new[](size_t size) {
+	return operator new(size);
+}
+
+void operator delete(void* p) noexcept {
+	std::free(p);
+}
+
+void operator delete[](void* p) noexcept {
+	std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+	std::free(p);
+}
+
+void operator delete[](void* p, size_t) noexcept {
+	std::free(p);
+}
+
+// input connection combinations, applied to both VCOs
+enum Connection {
+	PITCH_CONNECTED = 1 << 0,
+	SUB_CONNECTED = 1 << 1,
+	PWM_CONNECTED = 1 << 2,
+	CONNECTIONS_LEN = 1 << 3,
+	// FM is timed in its own table rather than in the full sweep
+	EXP_FM_CONNECTED = 1 << 3,
+	LIN_FM_CONNECTED = 1 << 4,
+	CLOCK_CONNECTED = 1 << 5,
+	SYNC_CONNECTED = 1 << 6
+};
+
+static const float sampleRates[] = {44100.f, 48000.f, 96000.f, 192000.f};
+static const char* waveformNames[] = {"saw", "sqr<-saw", "sqr"};
+static const char* quantizeNames[] = {"off", "12ET", "8ET", "12JI", "8JI"};
+static const char* modeNames[] = {"edge", "phase", "rhythm"};
+
+// sets of patched outputs, as bit masks of the output ids
+struct Patching {
+	const char* name;
+	int outputs;
+};
+
+static const int ALL_OUTPUTS = (1 << SubharmonicGenerator::OUTPUTS_LEN) - 1;
+static const Patching patchings[] = {
+	{"all", ALL_OUTPUTS},
+	{"total", 1 << SubharmonicGenerator::TOTAL_OUTPUT},
+	{"vco1", 1 << SubharmonicGenerator::VCO1_OUTPUT},
+	{"vco1 subs", 1 << SubharmonicGenerator::VCO1_SUB1_OUTPUT | 1 << SubharmonicGenerator::VCO1_SUB2_OUTPUT},
+	{"vco2 sub1", 1 << SubharmonicGenerator::VCO2_SUB1_OUTPUT},
+	{"none", 0}
+};
+
+// mix bus settings, in the mix table
+struct MixSetup {
+	const char* name;
+	int saturation;
+	bool dcBlocker;
+	float spread;
+	int outputs;
+};
+
+static const int TOTAL_OUTPUTS = 1 << SubharmonicGenerator::TOTAL_OUTPUT | 1 << SubharmonicGenerator::TOTAL_RIGHT_OUTPUT;
+
+// slow modulation sources, precomputed so they stay out of the timing
+static const int CV_LENGTH = 1 << 14;
+static float pitchCv[CV_LENGTH];
+static float subCv[CV_LENGTH];
+static float pwmCv[CV_LENGTH];
+static float expFmCv[CV_LENGTH];
+static float linFmCv[CV_LENGTH];
+static float clockCv[CV_LENGTH];
+static float syncCv[CV_LENGTH];
+
+static void buildCv() {
+	for (int i = 0; i < CV_LENGTH; i++) {
+		float t = (float) i / CV_LENGTH;
+		pitchCv[i] = std::sin(2.f * M_PI * t);
+		subCv[i] = 10.f * t - 5.f;
+		pwmCv[i] = 4.f * std::sin(2.f * M_PI * 3.f * t);
+		// audio rate, the linear FM takes the frequency through zero
+		expFmCv[i] = 2.f * std::sin(2.f * M_PI * 100.f * t);
+		linFmCv[i] = 10.f * std::sin(2.f * M_PI * 73.f * t);
+		// a 64 step clock with 25% pulses
+		clockCv[i] = (i & 255) < 64 ? 10.f : 0.f;
+		// sync pulses every 97 samples, rising over 3 so each lands between samples
+		syncCv[i] = std::min(10.f, 10.f / 3.f * (i % 97));
+	}
+}
+
+static std::string connectionName(int connections) {
+	if (connections == 0)
+		return "none";
+
+	std::string name;
+	if (connections & PITCH_CONNECTED)
+		name += "pitch+";
+	if (connections & SUB_CONNECTED)
+		name += "sub+";
+	if (connections & PWM_CONNECTED)
+		name += "pwm+";
+	if (connections & EXP_FM_CONNECTED)
+		name += "expfm+";
+	if (connections & LIN_FM_CONNECTED)
+		name += "linfm+";
+	if (connections & CLOCK_CONNECTED)
+		name += "clock+";
+	if (connections & SYNC_CONNECTED)
+		name += "sync+";
+	name.pop_back();
+	return name;
+}
+
+struct Result {
+	double nsPerSample;
+	long allocations;
+};
+
+static const int pitchInputs[] = {SubharmonicGenerator::VCO1_INPUT, SubharmonicGenerator::VCO2_INPUT};
+static const int subInputs[] = {SubharmonicGenerator::VCO1_SUB_INPUT, SubharmonicGenerator::VCO2_SUB_INPUT};
+static const int pwmInputs[] = {SubharmonicGenerator::VCO1_PWM_INPUT, SubharmonicGenerator::VCO2_PWM_INPUT};
+
+static void setUp(SubharmonicGenerator& module, int waveform, int quantize, int connections, int channels, int patched, int dividerMode, int wavetable = 0, int oversample = 1) {
+	module.dividerMode = dividerMode;
+	module.wavetable = wavetable;
+	module.setOversample(oversample);
+
+	// defaults give silence, so open every level and spread the divisions
+	module.params[SubharmonicGenerator::OSC_PARAM].setValue(261.63f);
+	module.params[SubharmonicGenerator::OSC_PARAM + 1].setValue(392.f);
+	module.params[SubharmonicGenerator::QUANTIZE_PARAM].setValue(quantize);
+	for (int i = 0; i < 2; i++) {
+		module.params[SubharmonicGenerator::WAVEFORM_PARAM + i].setValue(waveform);
+		module.params[SubharmonicGenerator::OSC_LEVEL_PARAM + i].setValue(1.f);
+	}
+	for (int i = 0; i < 4; i++) {
+		module.params[SubharmonicGenerator::SUB_PARAM + i].setValue(2 + 3 * i);
+		module.params[SubharmonicGenerator::SUB_LEVEL_PARAM + i].setValue(1.f);
+	}
+
+	for (int o = 0; o < SubharmonicGenerator::OUTPUTS_LEN; o++)
+		module.outputs[o].channels = (patched >> o) & 1;
+
+	for (int v = 0; v < 2; v++) {
+		if (connections & PITCH_CONNECTED)
+			module.inputs[pitchInputs[v]].channels = channels;
+		if (connections & SUB_CONNECTED)
+			module.inputs[subInputs[v]].channels = 1;
+		if (connections & PWM_CONNECTED)
+			module.inputs[pwmInputs[v]].channels = 1;
+		if (connections & EXP_FM_CONNECTED)
+			module.inputs[SubharmonicGenerator::EXP_FM_INPUT + v].channels = channels;
+		if (connections & LIN_FM_CONNECTED)
+			module.inputs[SubharmonicGenerator::LIN_FM_INPUT + v].channels = channels;
+		if (connections & SYNC_CONNECTED)
+			module.inputs[SubharmonicGenerator::SYNC_INPUT + v].channels = 1;
+	}
+	if (connections & CLOCK_CONNECTED)
+		module.inputs[SubharmonicGenerator::CLOCK_INPUT].channels = 1;
+}
+
+// write one frame of the CV sweeps to a module's inputs
+static void writeCv(SubharmonicGenerator& module, long i, int channels) {
+	int n = i & (CV_LENGTH - 1);
+	for (int v = 0; v < 2; v++) {
+		for (int c = 0; c < channels; c++)
+			module.inputs[pitchInputs[v]].voltages[c] = pitchCv[n] + c / 12.f;
+		module.inputs[subInputs[v]].voltages[0] = subCv[n];
+		module.inputs[pwmInputs[v]].voltages[0] = pwmCv[n];
+		for (int c = 0; c < channels; c++) {
+			module.inputs[SubharmonicGenerator::EXP_FM_INPUT + v].voltages[c] = expFmCv[n];
+			module.inputs[SubharmonicGenerator::LIN_FM_INPUT + v].voltages[c] = linFmCv[n];
+		}
+		module.inputs[SubharmonicGenerator::SYNC_INPUT + v].voltages[0] = syncCv[n];
+	}
+	module.inputs[SubharmonicGenerator::CLOCK_INPUT].voltages[0] = clockCv[n];
+}
+
+static Result runCase(float sampleRate, int waveform, int quantize, int connections, long frames, int channels, int patched = ALL_OUTPUTS, ProfileTotals* profile = nullptr,
+	int dividerMode = 0, int wavetable = 0, int oversample = 1, const MixSetup* mix = nullptr) {
+	SubharmonicGenerator module;
+	setUp(module, waveform, quantize, connections, channels, patched, dividerMode, wavetable, oversample);
+	if (mix) {
+		module.mixSaturation = mix->saturation;
+		module.mixDcBlocker = mix->dcBlocker;
+		module.stereoSpread = mix->spread;
+	}
+	module.profiler.enabled = profile != nullptr;
+
+	Module::ProcessArgs args;
+	args.sampleRate = sampleRate;
+	args.sampleTime = 1.f / sampleRate;
+	args.frame = 0;
+
+	allocations = 0;
+	countAllocations = true;
+	auto start = std::chrono::steady_clock::now();
+
+	for (long i = 0; i < frames; i++) {
+		writeCv(module, i, channels);
+		args.frame = i;
+		module.process(args);
+	}
+
+	auto end = std::chrono::steady_clock::now();
+	countAllocations = false;
+
+	if (profile) {
+		module.profiler.flush();
+		profile->drain(module.profiler);
+	}
+
+	Result result;
+	result.nsPerSample = std::chrono::duration<double, std::nano>(end - start).count() / frames;
+	result.allocations = allocations;
+	return result;
+}
+
+// The profiler reset partway through a record, as from the menu, with the UI thread
+// draining it before and after. Only the calls after the reset should be counted,
+// returns how many are counted otherwise
+static long runProfilerReset(long frames, int channels) {
+	SubharmonicGenerator module;
+	setUp(module, 0, 0, PITCH_CONNECTED, channels, ALL_OUTPUTS, 0);
+	module.profiler.enabled = true;
+	ProfileTotals profile;
+
+	Module::ProcessArgs args;
+	args.sampleRate = 48000.f;
+	args.sampleTime = 1.f / args.sampleRate;
+
+	// not a whole number of records, so one is open at the reset
+	long reset = frames / 2 + ProcessProfiler::RECORD_CALLS / 3;
+	for (long i = 0; i < frames; i++) {
+		if (i == reset) {
+			profile.drain(module.profiler);
+			module.profiler.restart();
+			profile.clear();
+		}
+		writeCv(module, i, channels);
+		args.frame = i;
+		module.process(args);
+	}
+	module.profiler.flush();
+	profile.drain(module.profiler);
+
+	return std::labs((long) profile.all.calls - (frames - reset));
+}
+
+// Many modules in one patch, each given a sample in turn as the engine does. Once
+// their state no longer fits in cache the cost per module grows with its size.
+// Returns ns per module per sample
+static Result runInstances(int count, int waveform, long frames, int channels) {
+	std::vector<SubharmonicGenerator*> modules;
+	for (int m = 0; m < count; m++) {
+		modules.push_back(new SubharmonicGenerator);
+		setUp(*modules.back(), waveform, 0, PITCH_CONNECTED, channels, ALL_OUTPUTS, 0);
+	}
+
+	Module::ProcessArgs args;
+	args.sampleRate = 48000.f;
+	args.sampleTime = 1.f / args.sampleRate;
+
+	allocations = 0;
+	countAllocations = true;
+	auto start = std::chrono::steady_clock::now();
+
+	for (long i = 0; i < frames; i++) {
+		args.frame = i;
+		for (SubharmonicGenerator* module : modules) {
+			writeCv(*module, i, channels);
+			module->process(args);
+		}
+	}
+
+	auto end = std::chrono::steady_clock::now();
+	countAllocations = false;
+
+	for (SubharmonicGenerator* module : modules)
+		delete module;
+
+	Result result;
+	result.nsPerSample = std::chrono::duration<double, std::nano>(end - start).count() / frames / count;
+	result.allocations = allocations;
+	return result;
+}
+
+// A unison stack of the given voices on each channel, detuned and spread across the
+// stereo mix. Returns ns per host sample
+static Result runUnison(int waveform, long frames, int channels, int voices) {
+	SubharmonicGenerator module;
+	setUp(module, waveform, 0, PITCH_CONNECTED, channels, ALL_OUTPUTS, 0);
+	module.unison = voices;
+	module.unisonDetune = 0.5f;
+	module.unisonSpread = 0.5f;
+
+	Module::ProcessArgs args;
+	args.sampleRate = 48000.f;
+	args.sampleTime = 1.f / args.sampleRate;
+
+	allocations = 0;
+	countAllocations = true;
+	auto start = std::chrono::steady_clock::now();
+
+	for (long i = 0; i < frames; i++) {
+		writeCv(module, i, channels);
+		args.frame = i;
+		module.process(args);
+	}
+
+	auto end = std::chrono::steady_clock::now();
+	countAllocations = false;
+
+	Result result;
+	result.nsPerSample = std::chrono::duration<double, std::nano>(end - start).count() / frames;
+	result.allocations = allocations;
+	return result;
+}
+
+// what sits to the right of the module in runBus()
+enum BusNeighbor {
+	BUS_NONE,
+	BUS_OTHER,
+	BUS_READER,
+	BUS_NEIGHBORS_LEN
+};
+
+static const char* busNeighborNames[BUS_NEIGHBORS_LEN] = {"none", "other module", "bus reader"};
+
+// A module on the right reading the voice bus, flipped after each sample as Rack's
+// engine does. Once the host answers the reader's request, each read should be the
+// host's state from the sample before, so a stale or torn message is counted. Any
+// flip asked of a module that never requested the bus counts too. Returns ns per
+// host sample
+static Result runBus(int waveform, long frames, int channels, int right, long* stale) {
+	SubharmonicGenerator module;
+	setUp(module, waveform, 0, PITCH_CONNECTED, channels, ALL_OUTPUTS, 0);
+	Module neighbor;
+	if (right != BUS_NONE) {
+		module.rightExpander.module = &neighbor;
+		neighbor.leftExpander.module = &module;
+	}
+	bool answered = false;
+
+	Module::ProcessArgs args;
+	args.sampleRate = 48000.f;
+	args.sampleTime = 1.f / args.sampleRate;
+
+	float sum = 0.f;
+	*stale = 0;
+	allocations = 0;
+	countAllocations = true;
+	auto start = std::chrono::steady_clock::now();
+
+	for (long i = 0; i < frames; i++) {
+		writeCv(module, i, channels);
+		args.frame = i;
+		module.process(args);
+
+		if (right == BUS_READER) {
+			VoiceBusMessage* message = (VoiceBusMessage*) neighbor.leftExpander.module->rightExpander.consumerMessage;
+			answered = answered || message->frame >= 0;
+			if (answered && (message->magic != VOICE_BUS_MAGIC || message->version != VOICE_BUS_VERSION || message->frame != i - 1 || message->channels != channels))
+				(*stale)++;
+			sum += message->subPhase[3][channels - 1];
+			message->requestBus();
+		}
+
+		Module::Expander& expander = module.rightExpander;
+		if (expander.messageFlipRequested) {
+			if (right != BUS_READER)
+				(*stale)++;
+			std::swap(expander.producerMessage, expander.consumerMessage);
+			expander.messageFlipRequested = false;
+		}
+	}
+
+	auto end = std::chrono::steady_clock::now();
+	countAllocations = false;
+
+	// keep the reads, and the reader should have been answered
+	if (sum != sum || (right == BUS_READER && !answered))
+		(*stale)++;
+
+	Result result;
+	result.nsPerSample = std::chrono::duration<double, std::nano>(end - start).count() / frames;
+	result.allocations = allocations;
+	return result;
+}
+
+// The panel scope's tap, every decimation samples, 0 for off, drained as the UI thread
+// would at 60 frames a second. Frames that never arrive are counted as lost. Returns
+// ns per host sample
+static Result runScope(int waveform, long frames, int channels, int decimation, long* lost) {
+	SubharmonicGenerator module;
+	setUp(module, waveform, 0, PITCH_CONNECTED, channels, ALL_OUTPUTS, 0);
+	module.scope.enabled = decimation > 0;
+	module.scope.decimation = decimation;
+	static ScopeHistory history;
+	history.clear();
+
+	Module::ProcessArgs args;
+	args.sampleRate = 48000.f;
+	args.sampleTime = 1.f / args.sampleRate;
+	const long drainFrames = 800;
+
+	long received = 0;
+	allocations = 0;
+	countAllocations = true;
+	auto start = std::chrono::steady_clock::now();
+
+	for (long i = 0; i < frames; i++) {
+		writeCv(module, i, channels);
+		args.frame = i;
+		module.process(args);
+		if (i % drainFrames == drainFrames - 1)
+			received += history.drain(module.scope);
+	}
+
+	auto end = std::chrono::steady_clock::now();
+	countAllocations = false;
+	received += history.drain(module.scope);
+	*lost = (decimation > 0 ? frames / decimation : 0) - received;
+
+	Result result;
+	result.nsPerSample = std::chrono::duration<double, std::nano>(end - start).count() / frames;
+	result.allocations = allocations;
+	return result;
+}
+
+int main(int argc, char** argv) {
+	long frames = argc > 1 ? std::atol(argv[1]) : 1000000;
+	int channels = argc > 2 ? clamp(std::atoi(argv[2]), 1, PORT_MAX_CHANNELS) : 1;
+	// the profiler's tick rate is measured from here, long before its figures are read
+	instrument::ticksPerNs();
+
+	std::printf("%d channel(s), %ld frames per case\n", channels, frames);
+	std::printf("%8s %-9s %-5s %-15s %12s %14s %8s\n", "rate", "waveform", "quant", "inputs", "ns/sample", "samples/sec", "allocs");
+
+	double worst = 0.0;
+	long totalAllocations = 0;
+
+	buildCv();
+
+	for (float sampleRate : sampleRates) {
+		for (int waveform = 0; waveform < 3; waveform++) {
+			for (int quantize = 0; quantize < 5; quantize++) {
+				for (int connections = 0; connections < CONNECTIONS_LEN; connections++) {
+					Result r = runCase(sampleRate, waveform, quantize, connections, frames, channels);
+					worst = std::max(worst, r.nsPerSample);
+					totalAllocations += r.allocations;
+
+					std::printf("%8.0f %-9s %-5s %-15s %12.1f %14.0f %8ld\n", sampleRate, waveformNames[waveform], quantizeNames[quantize],
+						connectionName(connections).c_str(), r.nsPerSample, 1e9 / r.nsPerSample, r.allocations);
+				}
+			}
+		}
+	}
+
+	// unheard VCOs and subs are skipped, so the cost follows what is patched
+	std::printf("\npatched outputs, 48000 Hz, pitch connected\n");
+	std::printf("%-9s %-10s %12s %10s %8s\n", "waveform", "patched", "ns/sample", "relative", "allocs");
+	for (int waveform = 0; waveform < 3; waveform++) {
+		double base = 0.0;
+		for (const Patching& patching : patchings) {
+			Result r = runCase(48000.f, waveform, 0, PITCH_CONNECTED, frames, channels, patching.outputs);
+			if (patching.outputs == ALL_OUTPUTS)
+				base = r.nsPerSample;
+			totalAllocations += r.allocations;
+
+			std::printf("%-9s %-10s %12.1f %9.2fx %8ld\n", waveformNames[waveform], patching.name, r.nsPerSample, r.nsPerSample / base, r.allocations);
+		}
+	}
+
+	// FM is read every sample, linear FM runs the through-zero kernels
+	const int fmConnections[] = {0, EXP_FM_CONNECTED, LIN_FM_CONNECTED, EXP_FM_CONNECTED | LIN_FM_CONNECTED};
+	std::printf("\naudio rate FM, 48000 Hz, pitch connected\n");
+	std::printf("%-9s %-22s %12s %10s %8s\n", "waveform", "inputs", "ns/sample", "relative", "allocs");
+	for (int mode = 0; mode < SubharmonicGenerator::RHYTHM_MODE; mode++) {
+		for (int waveform = 0; waveform < 3; waveform++) {
+			double base = 0.0;
+			for (int fm : fmConnections) {
+				Result r = runCase(48000.f, waveform, 0, PITCH_CONNECTED | fm, frames, channels, ALL_OUTPUTS, nullptr, mode);
+				if (fm == 0)
+					base = r.nsPerSample;
+				totalAllocations += r.allocations;
+
+				std::printf("%-9s %-22s %12.1f %9.2fx %8ld\n", waveformNames[waveform], (connectionName(PITCH_CONNECTED | fm) + " " + modeNames[mode]).c_str(),
+					r.nsPerSample, r.nsPerSample / base, r.allocations);
+			}
+		}
+	}
+
+	// hard sync, read every sample, and the resets it places, alone and through zero
+	const int syncConnections[] = {0, SYNC_CONNECTED, LIN_FM_CONNECTED, LIN_FM_CONNECTED | SYNC_CONNECTED};
+	std::printf("\nhard sync, 48000 Hz, pitch connected, a reset every 97 samples\n");
+	std::printf("%-9s %-22s %12s %10s %8s\n", "waveform", "inputs", "ns/sample", "relative", "allocs");
+	for (int mode = 0; mode < SubharmonicGenerator::RHYTHM_MODE; mode++) {
+		for (int waveform = 0; waveform < 3; waveform++) {
+			double base = 0.0;
+			for (int sync : syncConnections) {
+				Result r = runCase(48000.f, waveform, 0, PITCH_CONNECTED | sync, frames, channels, ALL_OUTPUTS, nullptr, mode);
+				if (sync == 0)
+					base = r.nsPerSample;
+				totalAllocations += r.allocations;
+
+				std::printf("%-9s %-22s %12.1f %9.2fx %8ld\n", waveformNames[waveform], (connectionName(PITCH_CONNECTED | sync) + " " + modeNames[mode]).c_str(),
+					r.nsPerSample, r.nsPerSample / base, r.allocations);
+			}
+		}
+	}
+
+	// the subs as clocked rhythms against the subs as audio, relative to the VCOs alone
+	const int vcoOutputs = 1 << SubharmonicGenerator::VCO1_OUTPUT | 1 << SubharmonicGenerator::VCO2_OUTPUT;
+	std::printf("\nrhythm mode, 48000 Hz, pitch and clock connected\n");
+	std::printf("%-9s %-22s %12s %10s %8s\n", "waveform", "subs", "ns/sample", "relative", "allocs");
+	for (int waveform = 0; waveform < 3; waveform++) {
+		Result vcos = runCase(48000.f, waveform, 0, PITCH_CONNECTED | CLOCK_CONNECTED, frames, channels, vcoOutputs);
+		Result subs = runCase(48000.f, waveform, 0, PITCH_CONNECTED | CLOCK_CONNECTED, frames, channels, ALL_OUTPUTS);
+		Result rhythm = runCase(48000.f, waveform, 0, PITCH_CONNECTED | CLOCK_CONNECTED, frames, channels, ALL_OUTPUTS, nullptr, SubharmonicGenerator::RHYTHM_MODE);
+		totalAllocations += vcos.allocations + subs.allocations + rhythm.allocations;
+
+		const char* names[] = {"not patched", "audio, edge counted", "rhythm"};
+		const Result* results[] = {&vcos, &subs, &rhythm};
+		for (int i = 0; i < 3; i++) {
+			std::printf("%-9s %-22s %12.1f %9.2fx %8ld\n", waveformNames[waveform], names[i],
+				results[i]->nsPerSample, results[i]->nsPerSample / vcos.nsPerSample, results[i]->allocations);
+		}
+	}
+
+	// the saws read from the wavetables against minBLEP saws, alone and oversampled
+	struct SawSource {
+		const char* name;
+		int wavetable;
+		int oversample;
+	};
+	const SawSource sawSources[] = {
+		{"minBLEP", SubharmonicGenerator::WAVETABLE_OFF, 1},
+		{"minBLEP 4x", SubharmonicGenerator::WAVETABLE_OFF, 4},
+		{"table saw", SubharmonicGenerator::WAVETABLE_SAW, 1},
+		{"table morph", SubharmonicGenerator::WAVETABLE_MORPH, 1},
+	};
+	std::printf("\nwavetables, 48000 Hz, pitch connected\n");
+	std::printf("%-9s %-22s %12s %10s %8s\n", "waveform", "saws", "ns/sample", "relative", "allocs");
+	for (int mode = 0; mode < SubharmonicGenerator::RHYTHM_MODE; mode++) {
+		for (int waveform = 0; waveform < 2; waveform++) {
+			double base = 0.0;
+			for (const SawSource& source : sawSources) {
+				Result r = runCase(48000.f, waveform, 0, PITCH_CONNECTED, frames, channels, ALL_OUTPUTS, nullptr, mode, source.wavetable, source.oversample);
+				if (source.wavetable == SubharmonicGenerator::WAVETABLE_OFF && source.oversample == 1)
+					base = r.nsPerSample;
+				totalAllocations += r.allocations;
+
+				std::printf("%-9s %-22s %12.1f %9.2fx %8ld\n", waveformNames[waveform], (std::string(source.name) + " " + modeNames[mode]).c_str(),
+					r.nsPerSample, r.nsPerSample / base, r.allocations);
+			}
+		}
+	}
+
+	// the mix bus on its own outputs, every voice heard through it
+	static const MixSetup mixSetups[] = {
+		{"hard clip", SubharmonicGenerator::MIX_HARD_CLIP, false, 0.f, 1 << SubharmonicGenerator::TOTAL_OUTPUT},
+		{"soft clip", SubharmonicGenerator::MIX_SOFT_CLIP, false, 0.f, 1 << SubharmonicGenerator::TOTAL_OUTPUT},
+		{"soft clip, DC blocker", SubharmonicGenerator::MIX_SOFT_CLIP, true, 0.f, 1 << SubharmonicGenerator::TOTAL_OUTPUT},
+		{"stereo, hard clip", SubharmonicGenerator::MIX_HARD_CLIP, false, 0.5f, TOTAL_OUTPUTS},
+		{"stereo, soft, DC", SubharmonicGenerator::MIX_SOFT_CLIP, true, 0.5f, TOTAL_OUTPUTS},
+	};
+	std::printf("\nmix bus, 48000 Hz, pitch connected\n");
+	std::printf("%-9s %-22s %12s %10s %8s\n", "waveform", "mix", "ns/sample", "relative", "allocs");
+	for (int waveform = 0; waveform < 3; waveform++) {
+		double base = 0.0;
+		for (const MixSetup& mix : mixSetups) {
+			Result r = runCase(48000.f, waveform, 0, PITCH_CONNECTED, frames, channels, mix.outputs, nullptr, 0, 0, 1, &mix);
+			if (&mix == mixSetups)
+				base = r.nsPerSample;
+			totalAllocations += r.allocations;
+
+			std::printf("%-9s %-22s %12.1f %9.2fx %8ld\n", waveformNames[waveform], mix.name, r.nsPerSample, r.nsPerSample / base, r.allocations);
+		}
+	}
+
+	// a mono unison stack against the same number of modules, each one voice
+	std::printf("\nunison, 48000 Hz, mono, pitch connected\n");
+	std::printf("%-9s %7s %12s %10s %14s %8s\n", "waveform", "voices", "ns/sample", "relative", "modules ns", "allocs");
+	for (int waveform = 0; waveform < 3; waveform++) {
+		double base = 0.0;
+		for (int voices : {1, 2, 4, 8}) {
+			Result r = runUnison(waveform, frames, 1, voices);
+			if (voices == 1)
+				base = r.nsPerSample;
+			totalAllocations += r.allocations;
+
+			std::printf("%-9s %7d %12.1f %9.2fx %14.1f %8ld\n", waveformNames[waveform], voices, r.nsPerSample, r.nsPerSample / base, voices * base, r.allocations);
+		}
+	}
+
+	// publishing the voice state to a module on the right that asks for it, which also
+	// keeps a silent VCO running for it, and any other module there costing nothing
+	long totalStale = 0;
+	std::printf("\nexpander bus, 48000 Hz, pitch connected\n");
+	std::printf("%-9s %-12s %12s %10s %8s %8s\n", "waveform", "right", "ns/sample", "relative", "stale", "allocs");
+	for (int waveform = 0; waveform < 3; waveform++) {
+		double base = 0.0;
+		for (int right = 0; right < BUS_NEIGHBORS_LEN; right++) {
+			long stale;
+			Result r = runBus(waveform, frames, channels, right, &stale);
+			if (right == BUS_NONE)
+				base = r.nsPerSample;
+			totalAllocations += r.allocations;
+			totalStale += stale;
+
+			std::printf("%-9s %-12s %12.1f %9.2fx %8ld %8ld\n", waveformNames[waveform], busNeighborNames[right], r.nsPerSample, r.nsPerSample / base, stale, r.allocations);
+		}
+	}
+
+	long totalLost = 0;
+	std::printf("\npanel scope, 48000 Hz, pitch connected\n");
+	std::printf("%-9s %-12s %12s %10s %8s %8s\n", "waveform", "tap", "ns/sample", "relative", "lost", "allocs");
+	for (int waveform = 0; waveform < 3; waveform++) {
+		double base = 0.0;
+		for (int decimation : {0, 1, 16}) {
+			long lost;
+			Result r = runScope(waveform, frames, channels, decimation, &lost);
+			if (decimation == 0)
+				base = r.nsPerSample;
+			totalAllocations += r.allocations;
+			totalLost += lost;
+
+			std::string tap = decimation == 0 ? "off" : decimation == 1 ? "every sample" : "every " + std::to_string(decimation);
+			std::printf("%-9s %-12s %12.1f %9.2fx %8ld %8ld\n", waveformNames[waveform], tap.c_str(), r.nsPerSample, r.nsPerSample / base, lost, r.allocations);
+		}
+	}
+
+	// the same work spread over more modules than fit in cache, each module's frames cut
+	// so every row takes about as long
+	std::printf("\ninstances, 48000 Hz, pitch connected, %zu bytes per module\n", sizeof(SubharmonicGenerator));
+	std::printf("%-9s %9s %12s %10s %8s\n", "waveform", "modules", "ns/sample", "relative", "allocs");
+	for (int waveform = 0; waveform < 3; waveform++) {
+		double base = 0.0;
+		for (int count : {1, 16, 64, 256}) {
+			Result r = runInstances(count, waveform, std::max(frames / count, 1000L), channels);
+			if (count == 1)
+				base = r.nsPerSample;
+			totalAllocations += r.allocations;
+
+			std::printf("%-9s %9d %12.1f %9.2fx %8ld\n", waveformNames[waveform], count, r.nsPerSample, r.nsPerSample / base, r.allocations);
+		}
+	}
+
+	// the profiler's figures should match the wall clock, less the CV writes in the loop
+	ProfileTotals profile;
+	Result plain = runCase(48000.f, 0, 0, PITCH_CONNECTED, frames, channels);
+	Result profiled = runCase(48000.f, 0, 0, PITCH_CONNECTED, frames, channels, ALL_OUTPUTS, &profile);
+	totalAllocations += plain.allocations + profiled.allocations;
+	std::printf("\nprofiler, 48000 Hz, saw, pitch connected\n");
+	std::printf("%.1f ns/sample off, %.1f ns/sample on, profiler reports %.1f ns mean and %.1f ns worst over %llu calls, %u records dropped\n",
+		plain.nsPerSample, profiled.nsPerSample, profile.nanoseconds((double) profile.all.ticks / profile.all.calls),
+		profile.nanoseconds(profile.all.worstTicks), (unsigned long long) profile.all.calls, profile.dropped);
+	long leaked = runProfilerReset(frames, channels);
+	std::printf("%ld calls from before a reset counted\n", leaked);
+
+	std::printf("worst case %.1f ns/sample, %ld allocations in process(), %ld stale voice bus messages, %ld lost scope frames\n", worst, totalAllocations, totalStale, totalLost);
+
+	return totalAllocations > 0 || totalStale > 0 || totalLost > 0 || leaked > 0 ? 1 : 0;
+}
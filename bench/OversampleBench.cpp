@@ -0,0 +1,75 @@
+//----------------------------------------------------------------------------
+//	RootNode - oversampling cost benchmark
+//	Times SubharmonicGenerator::process() at each oversampling factor for
+//	every waveform at 1, 4 and 16 channels, and reports ns/sample, the
+//	cost relative to no oversampling and the share of one core used at a
+//	48 kHz host rate.
+//
+//	usage: oversample_bench [frames per case]
+//----------------------------------------------------------------------------
+#include <chrono>
+#include <cstdlib>
+#include "SubharmonicGenerator.hpp"
+
+static const int factors[] = {1, 2, 4, 8};
+static const int channelCounts[] = {1, 4, 16};
+static const char* waveformNames[] = {"saw", "sqr<-saw", "sqr"};
+
+static double runCase(int factor, int waveform, int channels, long frames) {
+	SubharmonicGenerator module;
+	module.setOversample(factor);
+
+	module.params[SubharmonicGenerator::OSC_PARAM].setValue(261.63f);
+	module.params[SubharmonicGenerator::OSC_PARAM + 1].setValue(392.f);
+	for (int i = 0; i < 2; i++) {
+		module.params[SubharmonicGenerator::WAVEFORM_PARAM + i].setValue(waveform);
+		module.params[SubharmonicGenerator::OSC_LEVEL_PARAM + i].setValue(1.f);
+	}
+	for (int i = 0; i < 4; i++) {
+		module.params[SubharmonicGenerator::SUB_PARAM + i].setValue(2 + 3 * i);
+		module.params[SubharmonicGenerator::SUB_LEVEL_PARAM + i].setValue(1.f);
+	}
+
+	for (Output& output : module.outputs)
+		output.channels = 1;
+
+	// a chord across the channels
+	module.inputs[SubharmonicGenerator::VCO1_INPUT].channels = channels;
+	for (int c = 0; c < channels; c++)
+		module.inputs[SubharmonicGenerator::VCO1_INPUT].voltages[c] = c / 12.f;
+
+	Module::ProcessArgs args;
+	args.sampleRate = 48000.f;
+	args.sampleTime = 1.f / args.sampleRate;
+
+	auto start = std::chrono::steady_clock::now();
+	for (long i = 0; i < frames; i++) {
+		args.frame = i;
+		module.process(args);
+	}
+	auto end = std::chrono::steady_clock::now();
+
+	return std::chrono::duration<double, std::nano>(end - start).count() / frames;
+}
+
+int main(int argc, char** argv) {
+	long frames = argc > 1 ? std::atol(argv[1]) : 200000;
+
+	std::printf("%ld frames per case, 48 kHz host rate\n", frames);
+	std::printf("%-9s %8s %6s %12s %10s %10s\n", "waveform", "channels", "factor", "ns/sample", "relative", "core %");
+
+	for (int waveform = 0; waveform < 3; waveform++) {
+		for (int channels : channelCounts) {
+			double base = 0.0;
+			for (int factor : factors) {
+				double ns = runCase(factor, waveform, channels, frames);
+				if (factor == 1)
+					base = ns;
+
+				std::printf("%-9s %8d %5dx %12.1f %9.2fx %9.2f%%\n", waveformNames[waveform], channels, factor, ns, ns / base, ns * 48000.0 * 1e-9 * 100.0);
+			}
+		}
+	}
+
+	return 0;
+}
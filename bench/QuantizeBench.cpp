@@ -0,0 +1,96 @@
+//----------------------------------------------------------------------------
+//	RootNode - quantizer microbenchmark
+//	Compares the original log2/pow and linear scan quantizers against the
+//	ScaleTable quantizer in src/inc/Quantize.cpp, in quantizer calls per second.
+//----------------------------------------------------------------------------
+#include <chrono>
+#include <cstdio>
+#include <limits>
+#include <string>
+#include "../src/inc/Quantize.cpp"
+
+// the original quantizers, kept here as the baseline
+namespace legacy {
+
+double quantizeET(double frequency, double steps) {
+	double midiNote = 69 + steps * std::log2(frequency / A4_FREQUENCY);
+	double roundedMidi = std::round(midiNote);
+	return A4_FREQUENCY * std::pow(2.0, (roundedMidi - 69) / steps);
+}
+
+// the ratio scan is bounded by the element count here, the original used
+// sizeof(ratios) and read past the end of the array
+double quantizeJI(double frequency, const float* ratios, size_t count) {
+	double relativeFrequency = frequency / C4_FREQUENCY;
+	double octaveFactor = 1.f;
+
+	while (relativeFrequency >= 2.0) {
+		relativeFrequency /= 2.0;
+		octaveFactor *= 2.f;
+	}
+
+	double minError = std::numeric_limits<double>::max();
+	double closestRatio = 0.0;
+	std::string closestDegree;
+	for (size_t i = 0; i < count; ++i) {
+		double error = std::abs(relativeFrequency - ratios[i]);
+		if (error < minError) {
+			minError = error;
+			closestRatio = ratios[i];
+		}
+	}
+
+	return C4_FREQUENCY * closestRatio * octaveFactor;
+}
+
+const float ratios12[13] = { 1.f / 1.f, 16.f / 15.f, 9.f / 8.f, 6.f / 5.f, 5.f / 4.f, 4.f / 3.f,
+							45.f / 32.f, 3.f / 2.f, 8.f / 5.f, 5.f / 3.f, 9.f / 5.f, 15.f / 8.f, 2.f / 1.f };
+const float ratios8[8] = { 1.f / 1.f, 9.f / 8.f, 5.f / 4.f, 4.f / 3.f, 3.f / 2.f, 5.f / 3.f, 15.f / 8.f, 2.f / 1.f };
+
+float quantize(float frequency, int mode) {
+	switch (mode) {
+		case 1: return quantizeET(frequency, 12.0);
+		case 2: return quantizeET(frequency, 8.0);
+		case 3: return quantizeJI(frequency, ratios12, 13);
+		case 4: return quantizeJI(frequency, ratios8, 8);
+		default: return frequency;
+	}
+}
+
+}
+
+static const int CALLS = 10000000;
+static const char* modeNames[5] = {"off", "12ET", "8ET", "12JI", "8JI"};
+
+// sweeps the OSC_PARAM range so every call sees a new frequency
+static float sweep(int i) {
+	return 261.63f + (float) (i % 4096) * (4186.01f - 261.63f) / 4096.f;
+}
+
+template <typename F>
+static double callsPerSecond(F f, bool steady) {
+	volatile float sink = 0.f;
+	auto start = std::chrono::steady_clock::now();
+	for (int i = 0; i < CALLS; i++)
+		sink = sink + f(steady ? 440.f : sweep(i));
+	auto end = std::chrono::steady_clock::now();
+	return CALLS / std::chrono::duration<double>(end - start).count();
+}
+
+int main() {
+	std::printf("%-6s %-8s %16s %16s %8s\n", "mode", "input", "legacy calls/s", "table calls/s", "speedup");
+
+	for (int mode = 1; mode < 5; mode++) {
+		for (int steady = 0; steady < 2; steady++) {
+			Quantizer quantizer;
+			const ScaleTable* scale = builtinScales.get(mode);
+
+			double before = callsPerSecond([=](float f) { return legacy::quantize(f, mode); }, steady);
+			double after = callsPerSecond([&](float f) { return quantizer.process(scale, f); }, steady);
+
+			std::printf("%-6s %-8s %16.0f %16.0f %7.1fx\n", modeNames[mode], steady ? "steady" : "sweep", before, after, after / before);
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,406 @@
+//----------------------------------------------------------------------------
+//	RootNode - offline SubharmonicGenerator renderer
+//	Runs the module against the Rack stub from a scripted automation file,
+//	writes all eight outputs to a WAV or raw float file, and optionally
+//	compares them against a stored golden render.
+//
+//	usage: render <script> [-o out.wav|out.raw] [--golden file.raw] [--tolerance volts]
+//
+//	Script format, one statement per line, # starts a comment:
+//		rate <Hz>                       sample rate, default 48000
+//		length <seconds>                render length, default 1
+//		channels <n>                    channels of the pitch inputs when connected
+//		option <key> <value>            module option, applied through dataFromJson,
+//		                                a number or true/false. controlRate is the
+//		                                module's default unless set
+//		<time> set <target> <value>     set a param or input at time seconds
+//		<time> ramp <target> <value> <seconds>
+//		                                linear ramp from the current value
+//		<time> disconnect <input>
+//	Targets are enum names such as OSC_PARAM, SUB_PARAM+2 or VCO1_INPUT, an
+//	input target may end in :<channel> to set a single channel. Setting an
+//	input connects it.
+//----------------------------------------------------------------------------
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include "SubharmonicGenerator.hpp"
+
+struct Target {
+	const char* name;
+	bool isInput;
+	int id;
+};
+
+static const Target targets[] = {
+	{"OSC_PARAM", false, SubharmonicGenerator::OSC_PARAM},
+	{"SUB_PARAM", false, SubharmonicGenerator::SUB_PARAM},
+	{"OSC_LEVEL_PARAM", false, SubharmonicGenerator::OSC_LEVEL_PARAM},
+	{"SUB_LEVEL_PARAM", false, SubharmonicGenerator::SUB_LEVEL_PARAM},
+	{"WAVEFORM_PARAM", false, SubharmonicGenerator::WAVEFORM_PARAM},
+	{"QUANTIZE_PARAM", false, SubharmonicGenerator::QUANTIZE_PARAM},
+	{"VCO1_INPUT", true, SubharmonicGenerator::VCO1_INPUT},
+	{"VCO1_SUB_INPUT", true, SubharmonicGenerator::VCO1_SUB_INPUT},
+	{"VCO1_PWM_INPUT", true, SubharmonicGenerator::VCO1_PWM_INPUT},
+	{"VCO2_INPUT", true, SubharmonicGenerator::VCO2_INPUT},
+	{"VCO2_SUB_INPUT", true, SubharmonicGenerator::VCO2_SUB_INPUT},
+	{"VCO2_PWM_INPUT", true, SubharmonicGenerator::VCO2_PWM_INPUT},
+	{"CLOCK_INPUT", true, SubharmonicGenerator::CLOCK_INPUT},
+	{"SYNC_INPUT", true, SubharmonicGenerator::SYNC_INPUT},
+};
+
+static const char* outputNames[SubharmonicGenerator::OUTPUTS_LEN] = {
+	"VCO1", "VCO1_SUB1", "VCO1_SUB2", "TOTAL", "VCO2", "VCO2_SUB1", "VCO2_SUB2", "TOTAL_RIGHT"
+};
+
+enum EventType {
+	SET_EVENT,
+	RAMP_EVENT,
+	DISCONNECT_EVENT
+};
+
+struct Event {
+	long frame;
+	EventType type;
+	bool isInput;
+	int id;
+	// -1 for every channel of an input
+	int channel;
+	float value;
+	long rampFrames;
+};
+
+struct Ramp {
+	Event event;
+	float from;
+	long elapsed;
+};
+
+struct Script {
+	float sampleRate = 48000.f;
+	float length = 1.f;
+	int channels = 1;
+	json_t* options = json_object();
+	std::vector<Event> events;
+};
+
+static void fail(const std::string& message) {
+	std::fprintf(stderr, "render: %s\n", message.c_str());
+	std::exit(2);
+}
+
+// parses NAME, NAME+offset and NAME:channel
+static void parseTarget(const std::string& text, Event& event) {
+	std::string name = text;
+	int offset = 0;
+	event.channel = -1;
+
+	size_t colon = name.find(':');
+	if (colon != std::string::npos) {
+		event.channel = std::atoi(name.c_str() + colon + 1);
+		name = name.substr(0, colon);
+	}
+
+	size_t plus = name.find('+');
+	if (plus != std::string::npos) {
+		offset = std::atoi(name.c_str() + plus + 1);
+		name = name.substr(0, plus);
+	}
+
+	for (const Target& target : targets) {
+		if (name == target.name) {
+			event.isInput = target.isInput;
+			event.id = target.id + offset;
+			return;
+		}
+	}
+
+	fail("unknown target " + text);
+}
+
+static Script parseScript(const char* path) {
+	std::ifstream file(path);
+	if (!file)
+		fail(std::string("cannot open ") + path);
+
+	Script script;
+	std::vector<std::pair<double, Event>> timed;
+	std::string line;
+	int lineNumber = 0;
+
+	while (std::getline(file, line)) {
+		lineNumber++;
+		line = line.substr(0, line.find('#'));
+
+		std::istringstream in(line);
+		std::string first;
+		if (!(in >> first))
+			continue;
+
+		if (first == "rate") {
+			in >> script.sampleRate;
+		}
+		else if (first == "length") {
+			in >> script.length;
+		}
+		else if (first == "channels") {
+			in >> script.channels;
+			script.channels = clamp(script.channels, 1, PORT_MAX_CHANNELS);
+		}
+		else if (first == "option") {
+			std::string key, value;
+			if (!(in >> key >> value))
+				fail("bad option on line " + std::to_string(lineNumber));
+			if (value == "true" || value == "false")
+				json_object_set_new(script.options, key.c_str(), json_boolean(value == "true"));
+			else if (value.find('.') != std::string::npos)
+				json_object_set_new(script.options, key.c_str(), json_real(std::atof(value.c_str())));
+			else
+				json_object_set_new(script.options, key.c_str(), json_integer(std::atoll(value.c_str())));
+		}
+		else {
+			double time = std::atof(first.c_str());
+			std::string command, target;
+			Event event = {};
+			if (!(in >> command >> target))
+				fail("bad statement on line " + std::to_string(lineNumber));
+			parseTarget(target, event);
+
+			if (command == "set") {
+				event.type = SET_EVENT;
+				in >> event.value;
+			}
+			else if (command == "ramp") {
+				double duration = 0.0;
+				event.type = RAMP_EVENT;
+				in >> event.value >> duration;
+				event.rampFrames = std::max(1L, (long) std::lround(duration * script.sampleRate));
+			}
+			else if (command == "disconnect") {
+				event.type = DISCONNECT_EVENT;
+			}
+			else {
+				fail("unknown command " + command + " on line " + std::to_string(lineNumber));
+			}
+
+			timed.push_back(std::make_pair(time, event));
+		}
+	}
+
+	for (auto& t : timed) {
+		t.second.frame = std::lround(t.first * script.sampleRate);
+		script.events.push_back(t.second);
+	}
+	std::stable_sort(script.events.begin(), script.events.end(), [](const Event& a, const Event& b) {
+		return a.frame < b.frame;
+	});
+
+	return script;
+}
+
+static float getValue(SubharmonicGenerator& module, const Event& event) {
+	if (!event.isInput)
+		return module.params[event.id].getValue();
+	return module.inputs[event.id].getVoltage(std::max(event.channel, 0));
+}
+
+static void setValue(SubharmonicGenerator& module, const Event& event, float value, int channels) {
+	if (!event.isInput) {
+		module.params[event.id].setValue(value);
+		return;
+	}
+
+	Input& input = module.inputs[event.id];
+	if (!input.isConnected()) {
+		bool pitch = event.id == SubharmonicGenerator::VCO1_INPUT || event.id == SubharmonicGenerator::VCO2_INPUT;
+		input.channels = pitch ? channels : 1;
+	}
+
+	if (event.channel >= 0)
+		input.setVoltage(value, event.channel);
+	else {
+		for (int c = 0; c < PORT_MAX_CHANNELS; c++)
+			input.setVoltage(value, c);
+	}
+}
+
+static void writeWav(const char* path, const std::vector<float>& samples, int columns, float sampleRate) {
+	std::ofstream file(path, std::ios::binary);
+	if (!file)
+		fail(std::string("cannot write ") + path);
+
+	auto put32 = [&](uint32_t v) { file.write((const char*) &v, 4); };
+	auto put16 = [&](uint16_t v) { file.write((const char*) &v, 2); };
+	uint32_t dataSize = samples.size() * sizeof(float);
+
+	// 32 bit IEEE float WAV
+	file.write("RIFF", 4);
+	put32(36 + dataSize);
+	file.write("WAVEfmt ", 8);
+	put32(16);
+	put16(3);
+	put16(columns);
+	put32((uint32_t) sampleRate);
+	put32((uint32_t) sampleRate * columns * sizeof(float));
+	put16(columns * sizeof(float));
+	put16(32);
+	file.write("data", 4);
+	put32(dataSize);
+	file.write((const char*) samples.data(), dataSize);
+}
+
+static void writeRaw(const char* path, const std::vector<float>& samples) {
+	std::ofstream file(path, std::ios::binary);
+	if (!file)
+		fail(std::string("cannot write ") + path);
+	file.write((const char*) samples.data(), samples.size() * sizeof(float));
+}
+
+static std::vector<float> readRaw(const char* path) {
+	std::ifstream file(path, std::ios::binary | std::ios::ate);
+	if (!file)
+		fail(std::string("cannot open golden render ") + path);
+
+	std::vector<float> samples(file.tellg() / sizeof(float));
+	file.seekg(0);
+	file.read((char*) samples.data(), samples.size() * sizeof(float));
+	return samples;
+}
+
+// returns true when every sample of every output is within tolerance of the golden render
+static bool compare(const std::vector<float>& samples, const std::vector<float>& golden, int channels, float tolerance) {
+	if (samples.size() != golden.size()) {
+		std::printf("length mismatch: %zu samples rendered, %zu in golden render\n", samples.size(), golden.size());
+		return false;
+	}
+
+	int columns = SubharmonicGenerator::OUTPUTS_LEN * channels;
+	size_t frames = samples.size() / columns;
+	bool pass = true;
+
+	for (int o = 0; o < SubharmonicGenerator::OUTPUTS_LEN; o++) {
+		float maxError = 0.f;
+		size_t maxFrame = 0;
+		for (size_t f = 0; f < frames; f++) {
+			for (int c = 0; c < channels; c++) {
+				size_t i = f * columns + o * channels + c;
+				float error = std::fabs(samples[i] - golden[i]);
+				// a NaN is the worst error and stays reported
+				if (error > maxError || (std::isnan(error) && !std::isnan(maxError))) {
+					maxError = error;
+					maxFrame = f;
+				}
+			}
+		}
+
+		bool ok = maxError <= tolerance;
+		pass = pass && ok;
+		std::printf("  %-10s max error %.3g V at frame %zu %s\n", outputNames[o], maxError, maxFrame, ok ? "ok" : "FAIL");
+	}
+
+	return pass;
+}
+
+int main(int argc, char** argv) {
+	const char* scriptPath = nullptr;
+	const char* outPath = nullptr;
+	const char* goldenPath = nullptr;
+	float tolerance = 1e-4f;
+
+	for (int i = 1; i < argc; i++) {
+		std::string arg = argv[i];
+		if (arg == "-o" && i + 1 < argc)
+			outPath = argv[++i];
+		else if (arg == "--golden" && i + 1 < argc)
+			goldenPath = argv[++i];
+		else if (arg == "--tolerance" && i + 1 < argc)
+			tolerance = std::atof(argv[++i]);
+		else if (!scriptPath)
+			scriptPath = argv[i];
+		else
+			fail("unexpected argument " + arg);
+	}
+	if (!scriptPath)
+		fail("usage: render <script> [-o out.wav|out.raw] [--golden file.raw] [--tolerance volts]");
+
+	Script script = parseScript(scriptPath);
+
+	// like a patch saved by this version, which always has the control rate
+	SubharmonicGenerator module;
+	if (!json_object_get(script.options, "controlRate"))
+		json_object_set_new(script.options, "controlRate", json_integer(module.controlRate));
+	module.dataFromJson(script.options);
+	json_decref(script.options);
+
+	for (Output& output : module.outputs)
+		output.channels = 1;
+
+	Module::ProcessArgs args;
+	args.sampleRate = script.sampleRate;
+	args.sampleTime = 1.f / script.sampleRate;
+
+	long frames = std::lround(script.length * script.sampleRate);
+	int columns = SubharmonicGenerator::OUTPUTS_LEN * script.channels;
+	std::vector<float> samples;
+	samples.reserve(frames * columns);
+
+	std::vector<Ramp> ramps;
+	size_t next = 0;
+	auto start = std::chrono::steady_clock::now();
+
+	for (long f = 0; f < frames; f++) {
+		// apply the events scheduled for this frame
+		for (; next < script.events.size() && script.events[next].frame <= f; next++) {
+			const Event& event = script.events[next];
+			switch (event.type) {
+				case SET_EVENT:
+					setValue(module, event, event.value, script.channels);
+					break;
+				case RAMP_EVENT:
+					ramps.push_back(Ramp{event, getValue(module, event), 0});
+					break;
+				case DISCONNECT_EVENT:
+					module.inputs[event.id].channels = 0;
+					break;
+			}
+		}
+
+		for (size_t r = 0; r < ramps.size();) {
+			Ramp& ramp = ramps[r];
+			ramp.elapsed++;
+			float t = std::min(1.f, (float) ramp.elapsed / ramp.event.rampFrames);
+			setValue(module, ramp.event, crossfade(ramp.from, ramp.event.value, t), script.channels);
+			if (ramp.elapsed >= ramp.event.rampFrames)
+				ramps.erase(ramps.begin() + r);
+			else
+				r++;
+		}
+
+		args.frame = f;
+		module.process(args);
+
+		for (int o = 0; o < SubharmonicGenerator::OUTPUTS_LEN; o++) {
+			for (int c = 0; c < script.channels; c++)
+				samples.push_back(module.outputs[o].getVoltage(c));
+		}
+	}
+
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	std::printf("%s: %ld frames in %.3f s, %.1fx real time\n", scriptPath, frames, seconds, script.length / seconds);
+
+	if (outPath) {
+		std::string path = outPath;
+		if (path.size() > 4 && path.compare(path.size() - 4, 4, ".wav") == 0)
+			writeWav(outPath, samples, columns, script.sampleRate);
+		else
+			writeRaw(outPath, samples);
+	}
+
+	if (goldenPath) {
+		bool pass = compare(samples, readRaw(goldenPath), script.channels, tolerance);
+		std::printf("%s\n", pass ? "PASS" : "FAIL");
+		return pass ? 0 : 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,218 @@
+//----------------------------------------------------------------------------
+//	RootNode - real-time safety check for SubharmonicGenerator
+//	Built with RT_GUARD, so process() runs inside an rtguard::Scope. The heap
+//	functions below replace glibc's for the whole program and abort when
+//	called inside that scope, and the Rack log macros do the same through
+//	RealtimeGuard.hpp. Every control rate, sub oscillator mode, waveform,
+//	quantize mode and input connection combination is driven at 1 and 16
+//	channels, each control rate paired with one oversampling factor and the
+//	division change modes, wavetable shapes, mix bus settings, unison stacks
+//	and either a voice bus reader or the panel scope's tap spread across the
+//	cases, and hard sync with the PWM input. VCO2 is silenced for the middle third of
+//	each case so its idle and wake paths run too, and the 16 channel cases
+//	run with the profiler on. The run only completes when none of them
+//	allocates or logs.
+//
+//	usage: rt_guard [frames per case]
+//----------------------------------------------------------------------------
+#include <cmath>
+#include <cstdlib>
+#include <malloc.h>
+#include "SubharmonicGenerator.hpp"
+
+#ifndef RT_GUARD
+#error "rt_guard must be built with -DRT_GUARD"
+#endif
+
+// glibc's own allocator entry points, the replacements forward to these
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* p, size_t size);
+void* __libc_memalign(size_t alignment, size_t size);
+void __libc_free(void* p);
+
+void* malloc(size_t size) {
+	rtguard::check("malloc");
+	return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size) {
+	rtguard::check("calloc");
+	return __libc_calloc(count, size);
+}
+
+void* realloc(void* p, size_t size) {
+	rtguard::check("realloc");
+	return __libc_realloc(p, size);
+}
+
+void* memalign(size_t alignment, size_t size) {
+	rtguard::check("memalign");
+	return __libc_memalign(alignment, size);
+}
+
+void* aligned_alloc(size_t alignment, size_t size) {
+	rtguard::check("aligned_alloc");
+	return __libc_memalign(alignment, size);
+}
+
+int posix_memalign(void** p, size_t alignment, size_t size) {
+	rtguard::check("posix_memalign");
+	*p = __libc_memalign(alignment, size);
+	return *p ? 0 : ENOMEM;
+}
+
+void free(void* p) {
+	if (p)
+		rtguard::check("free");
+	__libc_free(p);
+}
+}
+
+// input connection combinations, applied to both VCOs
+enum Connection {
+	PITCH_CONNECTED = 1 << 0,
+	SUB_CONNECTED = 1 << 1,
+	PWM_CONNECTED = 1 << 2,
+	FM_CONNECTED = 1 << 3,
+	CONNECTIONS_LEN = 1 << 4
+};
+
+static const int controlRates[] = {1, 16, 32, 64};
+// paired with the control rates rather than multiplied, to keep the run short
+static const int oversampleFactors[] = {1, 2, 4, 8};
+static const int channelCounts[] = {1, 16};
+
+static void runCase(int controlRate, int oversample, int dividerMode, int waveform, int quantize, int connections, int channels, long frames) {
+	SubharmonicGenerator module;
+	module.setControlRate(controlRate);
+	module.setOversample(oversample);
+	module.dividerMode = dividerMode;
+	// each division change mode in turn, with and without hysteresis
+	module.divisionChange = (controlRate + waveform) % DIVISION_CHANGES_LEN;
+	module.divisionHysteresis = quantize % 2;
+	module.wavetable = (connections + waveform) % SubharmonicGenerator::WAVETABLES_LEN;
+	module.mixSaturation = connections % SubharmonicGenerator::MIX_SATURATIONS_LEN;
+	module.mixDcBlocker = quantize >= 2;
+	module.stereoSpread = 0.5f * waveform;
+	// unison stacks of 1 to 4 voices, cut down in the 16 channel cases
+	module.unison = 1 + (controlRate + connections) % 4;
+	module.unisonDetune = 0.3f * quantize;
+	module.unisonSpread = 0.5f;
+	module.profiler.enabled = channels > 1;
+	// half the cases publish the voice bus to a reader on the right
+	Module neighbor;
+	if (connections & 1) {
+		module.rightExpander.module = &neighbor;
+		neighbor.leftExpander.module = &module;
+	}
+	// and the other half feed the panel scope, left undrained so its ring fills
+	module.scope.enabled = !(connections & 1);
+	module.scope.decimation = 1 + quantize;
+	module.scope.vco = waveform % 2;
+
+	module.params[SubharmonicGenerator::OSC_PARAM].setValue(261.63f);
+	module.params[SubharmonicGenerator::OSC_PARAM + 1].setValue(392.f);
+	module.params[SubharmonicGenerator::QUANTIZE_PARAM].setValue(quantize);
+	for (int i = 0; i < 2; i++) {
+		module.params[SubharmonicGenerator::WAVEFORM_PARAM + i].setValue(waveform);
+		module.params[SubharmonicGenerator::OSC_LEVEL_PARAM + i].setValue(1.f);
+	}
+	for (int i = 0; i < 4; i++) {
+		module.params[SubharmonicGenerator::SUB_PARAM + i].setValue(2 + 3 * i);
+		module.params[SubharmonicGenerator::SUB_LEVEL_PARAM + i].setValue(1.f);
+	}
+
+	for (Output& output : module.outputs)
+		output.channels = 1;
+
+	const int pitchInputs[] = {SubharmonicGenerator::VCO1_INPUT, SubharmonicGenerator::VCO2_INPUT};
+	const int subInputs[] = {SubharmonicGenerator::VCO1_SUB_INPUT, SubharmonicGenerator::VCO2_SUB_INPUT};
+	const int pwmInputs[] = {SubharmonicGenerator::VCO1_PWM_INPUT, SubharmonicGenerator::VCO2_PWM_INPUT};
+	module.inputs[SubharmonicGenerator::CLOCK_INPUT].channels = connections & SUB_CONNECTED ? channels : 1;
+	module.rhythmOutput = quantize % SubharmonicGenerator::RHYTHM_OUTPUTS_LEN;
+	for (int v = 0; v < 2; v++) {
+		if (connections & PITCH_CONNECTED)
+			module.inputs[pitchInputs[v]].channels = channels;
+		if (connections & SUB_CONNECTED)
+			module.inputs[subInputs[v]].channels = 1;
+		if (connections & PWM_CONNECTED)
+			module.inputs[pwmInputs[v]].channels = 1;
+		if (connections & FM_CONNECTED) {
+			module.inputs[SubharmonicGenerator::EXP_FM_INPUT + v].channels = channels;
+			module.inputs[SubharmonicGenerator::LIN_FM_INPUT + v].channels = channels;
+		}
+		// hard sync rides along with the PWM input
+		if (connections & PWM_CONNECTED)
+			module.inputs[SubharmonicGenerator::SYNC_INPUT + v].channels = channels;
+	}
+
+	Module::ProcessArgs args;
+	args.sampleRate = 48000.f;
+	args.sampleTime = 1.f / args.sampleRate;
+
+	// sweep every input across its range so each divider and quantizer path is taken
+	for (long i = 0; i < frames; i++) {
+		float t = (float) i / frames;
+		if (i == frames / 3 || i == 2 * frames / 3) {
+			float level = i == frames / 3 ? 0.f : 1.f;
+			module.params[SubharmonicGenerator::OSC_LEVEL_PARAM + 1].setValue(level);
+			for (int s = 2; s < 4; s++)
+				module.params[SubharmonicGenerator::SUB_LEVEL_PARAM + s].setValue(level);
+		}
+
+		for (int v = 0; v < 2; v++) {
+			for (int c = 0; c < channels; c++)
+				module.inputs[pitchInputs[v]].voltages[c] = 6.f * t - 3.f + c / 12.f;
+			module.inputs[subInputs[v]].voltages[0] = 12.f * t - 6.f;
+			module.inputs[pwmInputs[v]].voltages[0] = 12.f * t - 6.f;
+			// audio rate FM, the linear input swings the frequency through zero
+			for (int c = 0; c < channels; c++) {
+				module.inputs[SubharmonicGenerator::EXP_FM_INPUT + v].voltages[c] = 2.f * std::sin(0.05f * i);
+				module.inputs[SubharmonicGenerator::LIN_FM_INPUT + v].voltages[c] = 10.f * std::sin(0.03f * i + c);
+			}
+		}
+
+		for (int c = 0; c < channels; c++)
+			module.inputs[SubharmonicGenerator::CLOCK_INPUT].voltages[c] = (i + 7 * c) % 100 < 30 ? 10.f : 0.f;
+		// sync pulses rising over a few samples, at a different rate per channel
+		for (int v = 0; v < 2; v++) {
+			for (int c = 0; c < channels; c++)
+				module.inputs[SubharmonicGenerator::SYNC_INPUT + v].voltages[c] = std::min(10.f, 2.5f * (i % (41 + 6 * c + 11 * v)));
+		}
+
+		args.frame = i;
+		module.process(args);
+		// the reader asks for the bus after every read
+		if (connections & 1)
+			((VoiceBusMessage*) module.rightExpander.consumerMessage)->requestBus();
+		if (module.rightExpander.messageFlipRequested) {
+			std::swap(module.rightExpander.producerMessage, module.rightExpander.consumerMessage);
+			module.rightExpander.messageFlipRequested = false;
+		}
+	}
+}
+
+int main(int argc, char** argv) {
+	long frames = argc > 1 ? std::atol(argv[1]) : 10000;
+	int cases = 0;
+
+	for (int rate = 0; rate < 4; rate++) {
+		for (int dividerMode = 0; dividerMode < SubharmonicGenerator::DIVIDER_MODES_LEN; dividerMode++) {
+			for (int waveform = 0; waveform < 3; waveform++) {
+				for (int quantize = 0; quantize < 5; quantize++) {
+					for (int connections = 0; connections < CONNECTIONS_LEN; connections++) {
+						for (int channels : channelCounts) {
+							runCase(controlRates[rate], oversampleFactors[rate], dividerMode, waveform, quantize, connections, channels, frames);
+							cases++;
+						}
+					}
+				}
+			}
+		}
+	}
+
+	std::printf("rt_guard: %d cases of %ld frames, no allocation or logging in process()\n", cases, frames);
+	return 0;
+}
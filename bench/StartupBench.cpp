@@ -0,0 +1,127 @@
+//----------------------------------------------------------------------------
+//	RootNode - plugin startup benchmark
+//	Times what Rack pays for this plugin before and while a patch opens: the
+//	shared tables, built when the plugin is loaded or with the first module,
+//	then patches of 1 to 256 SubharmonicGenerator instances, the first
+//	building the wavetables. Each instance is constructed, restored
+//	from JSON and given its first sample, and its widget's SVGs are looked
+//	up through asset::plugin() and Svg::load() as the widget does. Fails if
+//	any of the widget's SVGs does not load.
+//
+//	usage: startup_bench [plugin folder]
+//----------------------------------------------------------------------------
+#include <chrono>
+#include <cstdlib>
+#include <vector>
+#include <rack.hpp>
+#include "SubharmonicGenerator.hpp"
+
+Plugin* pluginInstance = nullptr;
+
+// the panel and the frames of PushButton5
+static const char* const svgPaths[] = {
+	"res/SubharmonicGenerator.svg",
+	"res/components/PushButton5_1.svg",
+	"res/components/PushButton5_2.svg",
+	"res/components/PushButton5_3.svg",
+	"res/components/PushButton5_4.svg",
+	"res/components/PushButton5_5.svg"
+};
+static const int SVG_COUNT = sizeof(svgPaths) / sizeof(svgPaths[0]);
+
+static double msSince(std::chrono::steady_clock::time_point start) {
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// a fresh copy of one of the shared tables
+template <typename T>
+static double buildMs() {
+	auto start = std::chrono::steady_clock::now();
+	T* table = new T;
+	double ms = msSince(start);
+	delete table;
+	return ms;
+}
+
+// the SVGs one SubharmonicGenerator widget asks for, returns how many loaded
+static int lookUpSvgs() {
+	int found = 0;
+	for (const char* path : svgPaths)
+		found += window::Svg::load(asset::plugin(pluginInstance, path)) != nullptr;
+	return found;
+}
+
+int main(int argc, char** argv) {
+	Plugin plugin;
+	plugin.path = argc > 1 ? argv[1] : "..";
+	pluginInstance = &plugin;
+
+	std::printf("shared tables\n");
+	std::printf("%-22s %-14s %10s\n", "table", "built", "ms");
+	struct Table {
+		const char* name;
+		bool atLoad;
+		double (*build)();
+	};
+	const Table tables[] = {
+		{"wavetables", false, buildMs<Wavetables>},
+		{"decimator filters", true, buildMs<DecimatorFilters>},
+		{"builtin scales", true, buildMs<BuiltinScales>},
+		{"soft clip", true, buildMs<SoftClipTable>},
+	};
+	double atLoad = 0.0;
+	for (const Table& table : tables) {
+		double ms = table.build();
+		if (table.atLoad)
+			atLoad += ms;
+		std::printf("%-22s %-14s %10.3f\n", table.name, table.atLoad ? "plugin load" : "first module", ms);
+	}
+	std::printf("%-22s %-14s %10.3f\n", "total", "plugin load", atLoad);
+
+	// the first lookups read the files, Rack's cache hands out the same ones after that
+	auto start = std::chrono::steady_clock::now();
+	int found = lookUpSvgs();
+	std::printf("\nfirst SVG lookups: %.3f ms, %d of %d files loaded\n", msSince(start), found, SVG_COUNT);
+
+	json_t* options = json_object();
+	json_object_set_new(options, "oversample", json_integer(2));
+	json_object_set_new(options, "wavetable", json_integer(SubharmonicGenerator::WAVETABLE_MORPH));
+	json_object_set_new(options, "controlRate", json_integer(16));
+
+	std::printf("\npatch load, per patch\n");
+	std::printf("%-9s %12s %14s %14s\n", "modules", "modules ms", "svg us", "per module us");
+	static const int counts[] = {1, 16, 64, 256};
+	for (int count : counts) {
+		std::vector<SubharmonicGenerator*> modules;
+		Module::ProcessArgs args;
+		args.sampleRate = 48000.f;
+		args.sampleTime = 1.f / args.sampleRate;
+		args.frame = 0;
+
+		start = std::chrono::steady_clock::now();
+		for (int i = 0; i < count; i++) {
+			SubharmonicGenerator* module = new SubharmonicGenerator;
+			module->dataFromJson(options);
+			module->process(args);
+			modules.push_back(module);
+		}
+		double moduleMs = msSince(start);
+
+		start = std::chrono::steady_clock::now();
+		for (int i = 0; i < count; i++)
+			found = std::min(found, lookUpSvgs());
+		double svgUs = 1e3 * msSince(start);
+
+		std::printf("%-9d %12.3f %14.2f %14.2f\n", count, moduleMs, svgUs, (1e3 * moduleMs + svgUs) / count);
+
+		for (SubharmonicGenerator* module : modules)
+			delete module;
+	}
+	json_decref(options);
+
+	if (found != SVG_COUNT) {
+		std::printf("missing SVG files in %s\n", plugin.path.c_str());
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,63 @@
+//----------------------------------------------------------------------------
+//	RootNode - minimal jansson stand-in for the headless bench builds
+//	Only the calls made by the module's dataToJson/dataFromJson are provided.
+//----------------------------------------------------------------------------
+#pragma once
+#include <map>
+#include <string>
+#include <vector>
+
+struct json_t {
+	enum Type { OBJECT, ARRAY, STRING, INTEGER, REAL, TRUE, FALSE, NUL } type = NUL;
+	long long integer = 0;
+	double real = 0.0;
+	std::string string;
+	std::map<std::string, json_t*> object;
+	std::vector<json_t*> array;
+};
+
+inline json_t* json_make(json_t::Type type) {
+	json_t* j = new json_t;
+	j->type = type;
+	return j;
+}
+
+inline void json_decref(json_t* j) {
+	if (!j)
+		return;
+	for (auto& it : j->object)
+		json_decref(it.second);
+	for (json_t* item : j->array)
+		json_decref(item);
+	delete j;
+}
+
+inline json_t* json_object() { return json_make(json_t::OBJECT); }
+inline json_t* json_array() { return json_make(json_t::ARRAY); }
+inline json_t* json_null() { return json_make(json_t::NUL); }
+inline json_t* json_boolean(bool b) { return json_make(b ? json_t::TRUE : json_t::FALSE); }
+inline json_t* json_integer(long long v) { json_t* j = json_make(json_t::INTEGER); j->integer = v; return j; }
+inline json_t* json_real(double v) { json_t* j = json_make(json_t::REAL); j->real = v; return j; }
+inline json_t* json_string(const char* s) { json_t* j = json_make(json_t::STRING); j->string = s; return j; }
+
+inline int json_object_set_new(json_t* o, const char* key, json_t* value) {
+	json_decref(o->object[key]);
+	o->object[key] = value;
+	return 0;
+}
+inline json_t* json_object_get(const json_t* o, const char* key) {
+	if (!o || o->type != json_t::OBJECT)
+		return nullptr;
+	auto it = o->object.find(key);
+	return it == o->object.end() ? nullptr : it->second;
+}
+inline int json_array_append_new(json_t* a, json_t* value) { a->array.push_back(value); return 0; }
+inline size_t json_array_size(const json_t* a) { return a ? a->array.size() : 0; }
+inline json_t* json_array_get(const json_t* a, size_t i) { return a && i < a->array.size() ? a->array[i] : nullptr; }
+
+inline long long json_integer_value(const json_t* j) { return j && j->type == json_t::INTEGER ? j->integer : 0; }
+inline double json_real_value(const json_t* j) { return j && j->type == json_t::REAL ? j->real : 0.0; }
+inline double json_number_value(const json_t* j) { return !j ? 0.0 : j->type == json_t::INTEGER ? j->integer : j->type == json_t::REAL ? j->real : 0.0; }
+inline const char* json_string_value(const json_t* j) { return j && j->type == json_t::STRING ? j->string.c_str() : nullptr; }
+inline bool json_is_true(const json_t* j) { return j && j->type == json_t::TRUE; }
+inline bool json_boolean_value(const json_t* j) { return json_is_true(j); }
@@ -0,0 +1,708 @@
+//----------------------------------------------------------------------------
+//	RootNode - minimal Rack SDK stand-in for the headless bench builds
+//	Covers the engine side of the Rack v2 API used by SubharmonicGenerator.hpp
+//	(simd, dsp, Module and its ports) with the same semantics as Rack, so the
+//	module's process() can be built and timed without Rack or its window.
+//	Nothing from app/ or widget/ is provided, only plugin paths and an Svg
+//	that reads its file, so the widget's SVG paths can be checked.
+//----------------------------------------------------------------------------
+#pragma once
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+#include <atomic>
+#include <complex>
+#include <limits>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include <pmmintrin.h>
+#include <smmintrin.h>
+#include <jansson.h>
+
+#include <cstdarg>
+
+#define DEBUG(format, ...) rack::logger::log(rack::logger::DEBUG_LEVEL, __FILE__, __LINE__, __FUNCTION__, format, ##__VA_ARGS__)
+#define INFO(format, ...) rack::logger::log(rack::logger::INFO_LEVEL, __FILE__, __LINE__, __FUNCTION__, format, ##__VA_ARGS__)
+#define WARN(format, ...) rack::logger::log(rack::logger::WARN_LEVEL, __FILE__, __LINE__, __FUNCTION__, format, ##__VA_ARGS__)
+
+#define ENUMS(name, count) name, name ## _LAST = name + (count) - 1
+#define PORT_MAX_CHANNELS 16
+
+
+namespace rack {
+
+namespace logger {
+
+enum Level {
+	DEBUG_LEVEL,
+	INFO_LEVEL,
+	WARN_LEVEL,
+	FATAL_LEVEL
+};
+
+inline void log(Level level, const char* filename, int line, const char* func, const char* format, ...) {
+	static const char* const names[] = {"debug", "info", "warn", "fatal"};
+	std::fprintf(stderr, "[%s %s:%d %s] ", names[level], filename, line, func);
+	va_list args;
+	va_start(args, format);
+	std::vfprintf(stderr, format, args);
+	va_end(args);
+	std::fprintf(stderr, "\n");
+}
+
+} // namespace logger
+
+namespace math {
+
+inline int clamp(int x, int a, int b) {
+	return std::max(std::min(x, b), a);
+}
+
+inline float clamp(float x, float a = 0.f, float b = 1.f) {
+	return std::fmax(std::fmin(x, b), a);
+}
+
+inline float rescale(float x, float xMin, float xMax, float yMin, float yMax) {
+	return yMin + (x - xMin) / (xMax - xMin) * (yMax - yMin);
+}
+
+inline float crossfade(float a, float b, float p) {
+	return a + (b - a) * p;
+}
+
+} // namespace math
+
+using namespace math;
+
+
+namespace simd {
+
+template <typename T, int N>
+struct Vector;
+
+template <>
+struct Vector<int32_t, 4>;
+
+template <>
+struct Vector<float, 4> {
+	using type = float;
+	constexpr static int size = 4;
+
+	union {
+		__m128 v;
+		float s[4];
+	};
+
+	Vector() = default;
+	Vector(__m128 v) : v(v) {}
+	Vector(float x) { v = _mm_set1_ps(x); }
+	Vector(float x1, float x2, float x3, float x4) { v = _mm_setr_ps(x1, x2, x3, x4); }
+
+	static Vector zero() { return Vector(_mm_setzero_ps()); }
+	static Vector mask() { return Vector(_mm_castsi128_ps(_mm_set1_epi32(-1))); }
+	static Vector load(const float* x) { return Vector(_mm_loadu_ps(x)); }
+	void store(float* x) { _mm_storeu_ps(x, v); }
+
+	float& operator[](int i) { return s[i]; }
+	const float& operator[](int i) const { return s[i]; }
+
+	static Vector cast(Vector<int32_t, 4> a);
+};
+
+template <>
+struct Vector<int32_t, 4> {
+	using type = int32_t;
+	constexpr static int size = 4;
+
+	union {
+		__m128i v;
+		int32_t s[4];
+	};
+
+	Vector() = default;
+	Vector(__m128i v) : v(v) {}
+	Vector(int32_t x) { v = _mm_set1_epi32(x); }
+	Vector(int32_t x1, int32_t x2, int32_t x3, int32_t x4) { v = _mm_setr_epi32(x1, x2, x3, x4); }
+	explicit Vector(Vector<float, 4> a) { v = _mm_cvttps_epi32(a.v); }
+
+	static Vector zero() { return Vector(_mm_setzero_si128()); }
+	static Vector mask() { return Vector(_mm_set1_epi32(-1)); }
+	static Vector load(const int32_t* x) { return Vector(_mm_loadu_si128((const __m128i*) x)); }
+	void store(int32_t* x) { _mm_storeu_si128((__m128i*) x, v); }
+
+	int32_t& operator[](int i) { return s[i]; }
+	const int32_t& operator[](int i) const { return s[i]; }
+
+	static Vector cast(Vector<float, 4> a) { return Vector(_mm_castps_si128(a.v)); }
+};
+
+inline Vector<float, 4> Vector<float, 4>::cast(Vector<int32_t, 4> a) {
+	return Vector(_mm_castsi128_ps(a.v));
+}
+
+typedef Vector<float, 4> float_4;
+typedef Vector<int32_t, 4> int32_4;
+
+#define FLOAT_4_OPERATOR(op, fn) \
+	inline float_4 operator op(const float_4& a, const float_4& b) { return float_4(fn(a.v, b.v)); } \
+	inline float_4& operator op##=(float_4& a, const float_4& b) { a = a op b; return a; }
+FLOAT_4_OPERATOR(+, _mm_add_ps)
+FLOAT_4_OPERATOR(-, _mm_sub_ps)
+FLOAT_4_OPERATOR(*, _mm_mul_ps)
+FLOAT_4_OPERATOR(/, _mm_div_ps)
+FLOAT_4_OPERATOR(&, _mm_and_ps)
+FLOAT_4_OPERATOR(|, _mm_or_ps)
+FLOAT_4_OPERATOR(^, _mm_xor_ps)
+#undef FLOAT_4_OPERATOR
+
+#define FLOAT_4_COMPARISON(op, fn) \
+	inline float_4 operator op(const float_4& a, const float_4& b) { return float_4(fn(a.v, b.v)); }
+FLOAT_4_COMPARISON(==, _mm_cmpeq_ps)
+FLOAT_4_COMPARISON(!=, _mm_cmpneq_ps)
+FLOAT_4_COMPARISON(<, _mm_cmplt_ps)
+FLOAT_4_COMPARISON(<=, _mm_cmple_ps)
+FLOAT_4_COMPARISON(>, _mm_cmpgt_ps)
+FLOAT_4_COMPARISON(>=, _mm_cmpge_ps)
+#undef FLOAT_4_COMPARISON
+
+inline float_4 operator-(const float_4& a) { return 0.f - a; }
+inline float_4 operator~(const float_4& a) { return a ^ float_4::mask(); }
+
+#define INT32_4_OPERATOR(op, fn) \
+	inline int32_4 operator op(const int32_4& a, const int32_4& b) { return int32_4(fn(a.v, b.v)); } \
+	inline int32_4& operator op##=(int32_4& a, const int32_4& b) { a = a op b; return a; }
+INT32_4_OPERATOR(+, _mm_add_epi32)
+INT32_4_OPERATOR(-, _mm_sub_epi32)
+INT32_4_OPERATOR(&, _mm_and_si128)
+INT32_4_OPERATOR(|, _mm_or_si128)
+INT32_4_OPERATOR(^, _mm_xor_si128)
+#undef INT32_4_OPERATOR
+
+inline int32_4 operator==(const int32_4& a, const int32_4& b) { return int32_4(_mm_cmpeq_epi32(a.v, b.v)); }
+inline int32_4 operator<(const int32_4& a, const int32_4& b) { return int32_4(_mm_cmplt_epi32(a.v, b.v)); }
+inline int32_4 operator>(const int32_4& a, const int32_4& b) { return int32_4(_mm_cmpgt_epi32(a.v, b.v)); }
+inline int32_4 operator~(const int32_4& a) { return a ^ int32_4::mask(); }
+inline int32_4 operator<<(const int32_4& a, int b) { return int32_4(_mm_slli_epi32(a.v, b)); }
+inline int32_4 operator>>(const int32_4& a, int b) { return int32_4(_mm_srai_epi32(a.v, b)); }
+
+using std::fmin;
+using std::fmax;
+using std::floor;
+using std::ceil;
+using std::round;
+using std::trunc;
+using std::fabs;
+using std::sqrt;
+using std::exp;
+using std::log;
+using std::pow;
+using std::sin;
+using std::cos;
+
+inline float_4 fmin(float_4 a, float_4 b) { return float_4(_mm_min_ps(a.v, b.v)); }
+inline float_4 fmax(float_4 a, float_4 b) { return float_4(_mm_max_ps(a.v, b.v)); }
+inline float_4 floor(float_4 a) { return float_4(_mm_floor_ps(a.v)); }
+inline float_4 ceil(float_4 a) { return float_4(_mm_ceil_ps(a.v)); }
+inline float_4 round(float_4 a) { return float_4(_mm_round_ps(a.v, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC)); }
+inline float_4 trunc(float_4 a) { return float_4(_mm_round_ps(a.v, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC)); }
+inline float_4 fabs(float_4 a) { return a & float_4::cast(int32_4(0x7fffffff)); }
+inline float_4 sqrt(float_4 a) { return float_4(_mm_sqrt_ps(a.v)); }
+
+// transcendental functions are evaluated per lane, like Rack's sse_mathfun fallbacks
+#define FLOAT_4_LANEWISE(name) \
+	inline float_4 name(float_4 a) { \
+		float_4 r; \
+		for (int i = 0; i < 4; i++) \
+			r.s[i] = std::name(a.s[i]); \
+		return r; \
+	}
+FLOAT_4_LANEWISE(exp)
+FLOAT_4_LANEWISE(log)
+FLOAT_4_LANEWISE(sin)
+FLOAT_4_LANEWISE(cos)
+#undef FLOAT_4_LANEWISE
+
+inline float_4 pow(float_4 a, float_4 b) { return exp(b * log(a)); }
+inline float_4 pow(float a, float_4 b) { return exp(b * std::log(a)); }
+
+inline float_4 andnot(const float_4& a, const float_4& b) { return float_4(_mm_andnot_ps(a.v, b.v)); }
+inline int movemask(const float_4& a) { return _mm_movemask_ps(a.v); }
+
+template <typename T>
+T movemaskInverse(int x);
+
+template <>
+inline float_4 movemaskInverse<float_4>(int x) {
+	__m128i bits = _mm_set_epi32(8, 4, 2, 1);
+	__m128i mask = _mm_cmpeq_epi32(_mm_and_si128(_mm_set1_epi32(x), bits), bits);
+	return float_4(_mm_castsi128_ps(mask));
+}
+
+inline float ifelse(bool cond, float a, float b) { return cond ? a : b; }
+inline float_4 ifelse(float_4 mask, float_4 a, float_4 b) { return (a & mask) | andnot(mask, b); }
+
+inline float clamp(float x, float a = 0.f, float b = 1.f) { return math::clamp(x, a, b); }
+inline float_4 clamp(float_4 x, float_4 a = 0.f, float_4 b = 1.f) { return fmin(fmax(x, a), b); }
+
+inline float rescale(float x, float xMin, float xMax, float yMin, float yMax) { return math::rescale(x, xMin, xMax, yMin, yMax); }
+inline float_4 rescale(float_4 x, float_4 xMin, float_4 xMax, float_4 yMin, float_4 yMax) { return yMin + (x - xMin) / (xMax - xMin) * (yMax - yMin); }
+
+inline float_4 crossfade(float_4 a, float_4 b, float_4 p) { return a + (b - a) * p; }
+
+} // namespace simd
+
+
+namespace dsp {
+
+static const float FREQ_C4 = 261.6256f;
+
+// dsp/approx.hpp, 2^floor(x) with the fraction in xf, for x above -127
+inline simd::float_4 exp2Floor(simd::float_4 x, simd::float_4* xf) {
+	x += 127.f;
+	simd::int32_4 xi(x);
+	if (xf)
+		*xf = x - simd::float_4(_mm_cvtepi32_ps(xi.v));
+	xi = xi << 23;
+	return simd::float_4::cast(xi);
+}
+
+// dsp/approx.hpp, 2^x with at most 6e-6 relative error, exact at integers
+template <typename T>
+T exp2_taylor5(T x) {
+	T xf;
+	T yi = exp2Floor(x, &xf);
+	T yf = 0.001879100722f;
+	yf = yf * xf + 0.008991698010f;
+	yf = yf * xf + 0.055817908652f;
+	yf = yf * xf + 0.2401595990753f;
+	yf = yf * xf + 0.69315169353961f;
+	yf = yf * xf + 1.f;
+	return yi * yf;
+}
+
+template <typename T = float>
+struct TSchmittTrigger {
+	T state;
+	TSchmittTrigger() { reset(); }
+	void reset() { state = T::mask(); }
+	T process(T in, T offThreshold = 0.f, T onThreshold = 1.f) {
+		T on = (in >= onThreshold);
+		T off = (in <= offThreshold);
+		T triggered = ~state & on;
+		state = on | (state & ~off);
+		return triggered;
+	}
+	T isHigh() { return state; }
+};
+
+template <>
+struct TSchmittTrigger<float> {
+	bool state = true;
+	void reset() { state = true; }
+	bool process(float in, float offThreshold = 0.f, float onThreshold = 1.f) {
+		if (state) {
+			if (in <= offThreshold)
+				state = false;
+		}
+		else if (in >= onThreshold) {
+			state = true;
+			return true;
+		}
+		return false;
+	}
+	bool isHigh() { return state; }
+};
+
+typedef TSchmittTrigger<> SchmittTrigger;
+
+struct ClockDivider {
+	uint32_t clock = 0;
+	uint32_t division = 1;
+
+	void reset() { clock = 0; }
+	void setDivision(uint32_t division) { this->division = division; }
+	uint32_t getDivision() { return division; }
+	uint32_t getClock() { return clock; }
+
+	bool process() {
+		clock++;
+		if (clock >= division) {
+			clock = 0;
+			return true;
+		}
+		return false;
+	}
+};
+
+struct PulseGenerator {
+	float remaining = 0.f;
+
+	void reset() { remaining = 0.f; }
+	void trigger(float duration = 1e-3f) {
+		if (duration > remaining)
+			remaining = duration;
+	}
+	bool process(float deltaTime) {
+		if (remaining > 0.f) {
+			remaining -= deltaTime;
+			return true;
+		}
+		return false;
+	}
+};
+
+// in place radix-2 FFT, used once per impulse table
+inline void fftInPlace(std::vector<std::complex<double>>& x, bool inverse) {
+	size_t n = x.size();
+	for (size_t i = 1, j = 0; i < n; i++) {
+		size_t bit = n >> 1;
+		for (; j & bit; bit >>= 1)
+			j ^= bit;
+		j ^= bit;
+		if (i < j)
+			std::swap(x[i], x[j]);
+	}
+	for (size_t len = 2; len <= n; len <<= 1) {
+		std::complex<double> w = std::polar(1.0, (inverse ? 2.0 : -2.0) * M_PI / len);
+		for (size_t i = 0; i < n; i += len) {
+			std::complex<double> wi = 1.0;
+			for (size_t k = 0; k < len / 2; k++) {
+				std::complex<double> a = x[i + k];
+				std::complex<double> b = x[i + k + len / 2] * wi;
+				x[i + k] = a + b;
+				x[i + k + len / 2] = a - b;
+				wi *= w;
+			}
+		}
+	}
+	if (inverse) {
+		for (auto& v : x)
+			v /= (double) n;
+	}
+}
+
+// minimum phase band limited step, built the same way as Rack's minBlepImpulse()
+inline void minBlepImpulse(int z, int o, float* output) {
+	int n = 2 * z * o;
+	std::vector<std::complex<double>> x(n);
+
+	// Blackman-Harris windowed sinc with z zero crossings on each side
+	for (int i = 0; i < n; i++) {
+		double p = -z + 2.0 * z * i / (n - 1);
+		double sinc = (p == 0.0) ? 1.0 : std::sin(M_PI * p) / (M_PI * p);
+		double t = (double) i / (n - 1);
+		double window = 0.35875 - 0.48829 * std::cos(2 * M_PI * t) + 0.14128 * std::cos(4 * M_PI * t) - 0.01168 * std::cos(6 * M_PI * t);
+		x[i] = sinc * window;
+	}
+
+	// real cepstrum, folded to make the impulse minimum phase
+	fftInPlace(x, false);
+	for (auto& v : x)
+		v = std::max(-30.0, std::log(std::abs(v)));
+	fftInPlace(x, true);
+	for (int i = 1; i < n / 2; i++)
+		x[i] *= 2.0;
+	for (int i = (n + 1) / 2; i < n; i++)
+		x[i] = 0.0;
+	fftInPlace(x, false);
+	for (auto& v : x)
+		v = std::exp(v);
+	fftInPlace(x, true);
+
+	// integrate and normalize the impulse into a step
+	double total = 0.0;
+	std::vector<double> step(n);
+	for (int i = 0; i < n; i++) {
+		total += x[i].real();
+		step[i] = total;
+	}
+	for (int i = 0; i < n; i++)
+		output[i] = (float) (step[i] / step[n - 1]);
+}
+
+template <int Z, int O, typename T = float>
+struct MinBlepGenerator {
+	T buf[2 * Z] = {};
+	int pos = 0;
+	float impulse[2 * Z * O + 1];
+
+	MinBlepGenerator() {
+		// the table is the same for every instance, build it once
+		static std::vector<float> table;
+		if (table.empty()) {
+			table.resize(2 * Z * O);
+			minBlepImpulse(Z, O, table.data());
+		}
+		std::copy(table.begin(), table.end(), impulse);
+		impulse[2 * Z * O] = 1.f;
+	}
+
+	// places a discontinuity with magnitude x at -1 < p <= 0 relative to the current frame
+	void insertDiscontinuity(float p, T x) {
+		if (!(-1 < p && p <= 0))
+			return;
+		for (int j = 0; j < 2 * Z; j++) {
+			float minBlepIndex = ((float) j - p) * O;
+			int index = (int) minBlepIndex;
+			float indexFrac = minBlepIndex - index;
+			float minBlepFrac = impulse[index] + (impulse[index + 1] - impulse[index]) * indexFrac;
+			buf[(pos + j) % (2 * Z)] += x * (-1.f + minBlepFrac);
+		}
+	}
+
+	T process() {
+		T v = buf[pos];
+		buf[pos] = T(0.f);
+		pos = (pos + 1) % (2 * Z);
+		return v;
+	}
+};
+
+} // namespace dsp
+
+
+namespace engine {
+
+struct Param {
+	float value = 0.f;
+
+	float getValue() { return value; }
+	void setValue(float value) { this->value = value; }
+};
+
+struct Light {
+	float value = 0.f;
+
+	void setBrightness(float brightness) { value = brightness; }
+	float getBrightness() { return value; }
+};
+
+struct Port {
+	union {
+		float voltages[PORT_MAX_CHANNELS] = {};
+		float value;
+	};
+	// 0 means disconnected, as in Rack
+	uint8_t channels = 0;
+
+	void setVoltage(float voltage, int channel = 0) { voltages[channel] = voltage; }
+	float getVoltage(int channel = 0) { return voltages[channel]; }
+	float getPolyVoltage(int channel) { return isMonophonic() ? getVoltage(0) : getVoltage(channel); }
+
+	template <typename T>
+	T getVoltageSimd(int firstChannel) { return T::load(&voltages[firstChannel]); }
+	template <typename T>
+	T getPolyVoltageSimd(int firstChannel) { return isMonophonic() ? T(getVoltage(0)) : getVoltageSimd<T>(firstChannel); }
+	template <typename T>
+	void setVoltageSimd(T voltage, int firstChannel) { voltage.store(&voltages[firstChannel]); }
+
+	// sets the channel count of a connected port, disconnected ports stay at 0
+	void setChannels(int channels) {
+		if (this->channels == 0)
+			return;
+		for (int c = channels; c < this->channels; c++)
+			voltages[c] = 0.f;
+		this->channels = std::max(channels, 1);
+	}
+	int getChannels() { return channels; }
+	bool isConnected() { return channels > 0; }
+	bool isMonophonic() { return channels == 1; }
+	bool isPolyphonic() { return channels > 1; }
+};
+
+struct Input : Port {};
+struct Output : Port {};
+
+struct ParamQuantity {
+	float minValue = 0.f;
+	float maxValue = 1.f;
+	float defaultValue = 0.f;
+	std::string name;
+	std::string unit;
+	bool snapEnabled = false;
+	virtual ~ParamQuantity() {}
+};
+
+struct SwitchQuantity : ParamQuantity {
+	std::vector<std::string> labels;
+};
+
+struct PortInfo {
+	std::string name;
+	std::string description;
+	virtual ~PortInfo() {}
+};
+
+struct Module {
+	std::vector<Param> params;
+	std::vector<Input> inputs;
+	std::vector<Output> outputs;
+	std::vector<Light> lights;
+	std::vector<ParamQuantity*> paramQuantities;
+	std::vector<PortInfo*> inputInfos;
+	std::vector<PortInfo*> outputInfos;
+
+	struct Expander {
+		int64_t moduleId = -1;
+		Module* module = nullptr;
+		void* producerMessage = nullptr;
+		void* consumerMessage = nullptr;
+		bool messageFlipRequested = false;
+
+		void requestMessageFlip() { messageFlipRequested = true; }
+	};
+	Expander leftExpander;
+	Expander rightExpander;
+
+	struct ProcessArgs {
+		float sampleRate;
+		float sampleTime;
+		int64_t frame;
+	};
+	struct SampleRateChangeEvent {
+		float sampleRate;
+		float sampleTime;
+	};
+	struct ResetEvent {};
+	struct ExpanderChangeEvent {
+		uint8_t side;
+	};
+
+	virtual ~Module() {
+		for (ParamQuantity* q : paramQuantities)
+			delete q;
+		for (PortInfo* i : inputInfos)
+			delete i;
+		for (PortInfo* i : outputInfos)
+			delete i;
+	}
+
+	void config(int numParams, int numInputs, int numOutputs, int numLights = 0) {
+		params.resize(numParams);
+		inputs.resize(numInputs);
+		outputs.resize(numOutputs);
+		lights.resize(numLights);
+		paramQuantities.resize(numParams, nullptr);
+		inputInfos.resize(numInputs, nullptr);
+		outputInfos.resize(numOutputs, nullptr);
+	}
+
+	template <class TParamQuantity = ParamQuantity>
+	TParamQuantity* configParam(int paramId, float minValue, float maxValue, float defaultValue, std::string name = "", std::string unit = "", float displayBase = 0.f, float displayMultiplier = 1.f, float displayOffset = 0.f) {
+		delete paramQuantities[paramId];
+		TParamQuantity* q = new TParamQuantity;
+		q->minValue = minValue;
+		q->maxValue = maxValue;
+		q->defaultValue = defaultValue;
+		q->name = name;
+		q->unit = unit;
+		paramQuantities[paramId] = q;
+		params[paramId].value = defaultValue;
+		return q;
+	}
+
+	template <class TSwitchQuantity = SwitchQuantity>
+	TSwitchQuantity* configSwitch(int paramId, float minValue, float maxValue, float defaultValue, std::string name = "", std::vector<std::string> labels = {}) {
+		TSwitchQuantity* q = configParam<TSwitchQuantity>(paramId, minValue, maxValue, defaultValue, name);
+		q->snapEnabled = true;
+		q->labels = labels;
+		return q;
+	}
+
+	template <class TPortInfo = PortInfo>
+	TPortInfo* configInput(int portId, std::string name = "") {
+		delete inputInfos[portId];
+		TPortInfo* info = new TPortInfo;
+		info->name = name;
+		inputInfos[portId] = info;
+		return info;
+	}
+
+	template <class TPortInfo = PortInfo>
+	TPortInfo* configOutput(int portId, std::string name = "") {
+		delete outputInfos[portId];
+		TPortInfo* info = new TPortInfo;
+		info->name = name;
+		outputInfos[portId] = info;
+		return info;
+	}
+
+	template <class TParamQuantity = ParamQuantity>
+	TParamQuantity* getParamQuantity(int paramId) {
+		return dynamic_cast<TParamQuantity*>(paramQuantities[paramId]);
+	}
+
+	virtual void process(const ProcessArgs& args) {}
+	virtual json_t* dataToJson() { return NULL; }
+	virtual void dataFromJson(json_t* rootJ) {}
+	virtual void onSampleRateChange(const SampleRateChangeEvent& e) {}
+	virtual void onReset(const ResetEvent& e) {
+		for (size_t i = 0; i < params.size(); i++) {
+			if (paramQuantities[i])
+				params[i].setValue(paramQuantities[i]->defaultValue);
+		}
+	}
+	virtual void onExpanderChange(const ExpanderChangeEvent& e) {}
+};
+
+} // namespace engine
+
+using namespace engine;
+
+namespace plugin {
+
+struct Plugin {
+	// the plugin's folder
+	std::string path;
+};
+
+} // namespace plugin
+
+using plugin::Plugin;
+
+namespace asset {
+
+inline std::string plugin(Plugin* plugin, const std::string& filename) {
+	return plugin->path + "/" + filename;
+}
+
+} // namespace asset
+
+namespace window {
+
+// Like Rack's, load() keeps every file it is asked for, failures included, in a map
+// by path and hands the same one out again. The file is read but not parsed
+struct Svg {
+	std::string data;
+
+	static std::shared_ptr<Svg> load(const std::string& filename) {
+		static std::map<std::string, std::shared_ptr<Svg>> cache;
+		auto it = cache.find(filename);
+		if (it != cache.end())
+			return it->second;
+
+		std::shared_ptr<Svg> svg;
+		FILE* file = std::fopen(filename.c_str(), "rb");
+		if (file) {
+			svg = std::make_shared<Svg>();
+			char buffer[4096];
+			size_t n;
+			while ((n = std::fread(buffer, 1, sizeof(buffer), file)) > 0)
+				svg->data.append(buffer, n);
+			std::fclose(file);
+		}
+		else {
+			WARN("SVG file %s does not exist", filename.c_str());
+		}
+		cache[filename] = svg;
+		return svg;
+	}
+};
+
+} // namespace window
+
+} // namespace rack
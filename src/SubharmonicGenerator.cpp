@@ -1,237 +1,276 @@
 #include "plugin.hpp"
-#include <cmath>
-#include "inc/WaveformConverter.hpp"
-#include "inc/FrequencyDivider.hpp"
-#include "inc/Utility.hpp"
-#include "inc/GateProcessor.hpp"
-#include "inc/Quantize.cpp"
+#include "SubharmonicGenerator.hpp"
+#include <fstream>
+#include <osdialog.h>
+
+
+// ask for a file with the given osdialog filter, returns false when cancelled or unreadable
+static bool chooseTextFile(const char* filter, std::string& path, std::string& text) {
+	osdialog_filters* filters = osdialog_filters_parse(filter);
+	char* pathC = osdialog_file(OSDIALOG_OPEN, NULL, NULL, filters);
+	osdialog_filters_free(filters);
+	if (!pathC)
+		return false;
+	path = pathC;
+	std::free(pathC);
+
+	std::ifstream file(path, std::ios::binary);
+	if (!file) {
+		osdialog_message(OSDIALOG_WARNING, OSDIALOG_OK, ("Could not open " + path).c_str());
+		return false;
+	}
+	text.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+	return true;
+}
 
-struct SquareWaveGenerator {
-    float phase = 0.f;
-    float freq = 0.f;
-	float dutyCycle = 0.5f;
+static void showTuningError(const std::string& path, const std::string& error) {
+	osdialog_message(OSDIALOG_WARNING, OSDIALOG_OK, (system::getFilename(path) + ": " + error).c_str());
+}
 
-    dsp::MinBlepGenerator<16, 16, float> sqrMinBlep;
+// share of one core taken by calls averaging the given time at the engine's sample rate
+static double corePercent(double nanoseconds) {
+	return nanoseconds * APP->engine->getSampleRate() * 1e-9 * 100.0;
+}
 
-    float sawValue = 0.f;
-    float sqrValue = 0.f;
+// a 0 to 1 module setting shown as a menu slider, such as the wavetable morph
+struct SettingQuantity : Quantity {
+	float* value;
+	float defaultValue;
+	std::string label;
 
-    void process(float deltaTime) {
-        // Advance phase
-        float deltaPhase = simd::clamp(freq * deltaTime, 0.f, 0.35f);
+	SettingQuantity(float* value, float defaultValue, std::string label) : value(value), defaultValue(defaultValue), label(label) {}
 
-        phase += deltaPhase;
+	void setValue(float v) override {
+		*value = clamp(v, 0.f, 1.f);
+	}
 
-       // Wrap phase to stay within [0, 1]
-        if (phase >= 1.0f)
-            phase -= 1.0f;
+	float getValue() override {
+		return *value;
+	}
 
-        // Calculate square wave based on phase
-        sqrValue = phase < dutyCycle ? 5.f : -5.f;
-        sqrValue += sqrMinBlep.process();
-    }
+	float getDefaultValue() override {
+		return defaultValue;
+	}
 
-    float sqr() {
-        return sqrValue;
-    }
+	std::string getLabel() override {
+		return label;
+	}
 
+	int getDisplayPrecision() override {
+		return 2;
+	}
 };
 
+struct SettingSlider : ui::Slider {
+	SettingSlider(float* value, float defaultValue, std::string label) {
+		quantity = new SettingQuantity(value, defaultValue, label);
+		box.size.x = 200.f;
+	}
 
-struct SubharmonicGenerator : Module {
-	enum ParamId {
-		ENUMS(OSC_PARAM, 2),
-		ENUMS(SUB_PARAM, 4),
-		ENUMS(OSC_LEVEL_PARAM, 2),
-		ENUMS(SUB_LEVEL_PARAM, 4),
-		ENUMS(WAVEFORM_PARAM, 2),
-		QUANTIZE_PARAM,
-		PARAMS_LEN
-	};
-	enum InputId {
-		VCO1_INPUT,
-		VCO1_SUB_INPUT,
-		VCO1_PWM_INPUT,
-		VCO2_INPUT,
-		VCO2_SUB_INPUT,
-		VCO2_PWM_INPUT,
-		INPUTS_LEN
-	};
-	enum OutputId {
-		VCO1_OUTPUT,
-		VCO1_SUB1_OUTPUT,
-		VCO1_SUB2_OUTPUT,
-		TOTAL_OUTPUT,
-		VCO2_OUTPUT,
-		VCO2_SUB1_OUTPUT,
-		VCO2_SUB2_OUTPUT,
-		OUTPUTS_LEN
-	};
-	enum LightId {
-		LIGHTS_LEN
-	};
-
-	SquareWaveGenerator oscillators[2];
-	WaveformConverter converters[6];
-	FrequencyDivider dividers[4];
-
-	SubharmonicGenerator() {
-		config(PARAMS_LEN, INPUTS_LEN, OUTPUTS_LEN, LIGHTS_LEN);
-		
-		// configure patchbay I/O
-		configInput(VCO1_INPUT, "");
-		configInput(VCO1_SUB_INPUT, "");
-		configInput(VCO1_PWM_INPUT, "");
-		configInput(VCO2_INPUT, "");
-		configInput(VCO2_SUB_INPUT, "");
-		configInput(VCO2_PWM_INPUT, "");
-		configOutput(VCO1_OUTPUT, "");
-		configOutput(VCO1_SUB1_OUTPUT, "");
-		configOutput(VCO1_SUB2_OUTPUT, "");
-		configOutput(TOTAL_OUTPUT, "");
-		configOutput(VCO2_OUTPUT, "");
-		configOutput(VCO2_SUB1_OUTPUT, "");
-		configOutput(VCO2_SUB2_OUTPUT, "");
-		configParam(QUANTIZE_PARAM, 0.0f, 4.0f, 0.0f, "Quantize Param");
-
-		// configure oscillator and mixer parameters
-		for (int i = 0; i < 4; i++) {
-			configParam(SUB_PARAM + i, 1.f, 16.f, 1.f, "");
-			configParam(SUB_LEVEL_PARAM + i, 0.f, 1.f, 0.f, "");
-
-			if (i < 2) {
-				configParam(OSC_LEVEL_PARAM + i, 0.f, 1.f, 0.f, "");
-				configParam(OSC_PARAM + i, 261.63, 4186.01, 0.f, "");
-				configSwitch(WAVEFORM_PARAM + i, 0.f, 2.f, 0.f, "Waveform", {"Saw", "Square<-Saw", "Square"});
-			}
-		}
+	~SettingSlider() {
+		delete quantity;
 	}
+};
 
-	// quantize notes based on switch position
-	float quantize(float freq, int mode) {
-		switch (mode) {
-			case 0:
-				return freq;
-			case 1:
-				return quantize12ET(freq);
-			case 2:
-				return quantize8ET(freq);
-			case 3:
-				return quantize12JI(freq);
-			case 4:
-				return quantize8JI(freq);
-			default:
-				return freq;
-		}
+// one row per audio path, most expensive first
+static std::vector<ProcessStats> sortedPaths(const ProfileTotals& profile) {
+	std::vector<ProcessStats> paths;
+	for (const auto& p : profile.paths)
+		paths.push_back(p.second);
+	std::sort(paths.begin(), paths.end(), [](const ProcessStats& a, const ProcessStats& b) {
+		return a.ticks > b.ticks;
+	});
+	return paths;
+}
+
+static void saveProfileCsv(const ProfileTotals& profile) {
+	osdialog_filters* filters = osdialog_filters_parse("CSV:csv");
+	char* pathC = osdialog_file(OSDIALOG_SAVE, NULL, "subharmonic-profile.csv", filters);
+	osdialog_filters_free(filters);
+	if (!pathC)
+		return;
+	std::string path = pathC;
+	std::free(pathC);
+
+	std::ofstream file(path);
+	if (!file) {
+		osdialog_message(OSDIALOG_WARNING, OSDIALOG_OK, ("Could not write " + path).c_str());
+		return;
 	}
 
-	void process(const ProcessArgs& args) override {
-		// process input values
-		float vco1_cv = pow(2.f, inputs[VCO1_INPUT].getVoltage());
-		float vco2_cv = pow(2.f, inputs[VCO2_INPUT].getVoltage());
-		int vco1_sub_cv = std::floor(rescale(inputs[VCO1_SUB_INPUT].getVoltage(), -5, 5, 0.f, 16.f));
-		int vco2_sub_cv = std::floor(rescale(inputs[VCO2_SUB_INPUT].getVoltage(), -5, 5, 0.f, 16.f));
-		float vco1_pwm = rescale(inputs[VCO1_PWM_INPUT].getVoltage(), -5, 5, 0.01, 0.99);
-		float vco2_pwm = rescale(inputs[VCO2_PWM_INPUT].getVoltage(), -5, 5, 0.01, 0.99);
+	file << "path,vco1,vco2,sub mode,quantize,oversample,max channels,fm,wavetable,sync,unison,calls,share %,mean ticks,worst ticks,mean ns,worst ns,core %\n";
+	for (const ProcessStats& stats : sortedPaths(profile)) {
+		uint32_t p = stats.path;
+		double meanTicks = (double) stats.ticks / stats.calls;
+		std::string description = SubharmonicGenerator::describeProfilePath(p);
+		file << "\"" << description << "\","
+			<< (p & 3) << "," << ((p >> 2) & 3) << "," << ((p >> 4) & 3) << "," << ((p >> 6) & 7) << ","
+			<< (1 << ((p >> 9) & 3)) << "," << 4 * (((p >> 11) & 3) + 1) << "," << ((p >> 13) & 3) << "," << ((p >> 15) & 1) << "," << ((p >> 16) & 1) << "," << ((p >> 17) & 1) << ","
+			<< stats.calls << "," << 100.0 * stats.ticks / std::max<uint64_t>(profile.all.ticks, 1) << ","
+			<< meanTicks << "," << stats.worstTicks << ","
+			<< profile.nanoseconds(meanTicks) << "," << profile.nanoseconds(stats.worstTicks) << ","
+			<< corePercent(profile.nanoseconds(meanTicks)) << "\n";
+	}
+}
+
+
+// The panel scope, drawn from the frames the module's tap hands over. Rack does not
+// draw widgets that are off screen, so the tap only runs while the display is on and
+// was drawn in the last UI frame
+struct ScopeDisplay : LedDisplay {
+	// frames across the waveform view, and the spectrum's transform length
+	static const int WINDOW = 256;
+	static const int FFT_SIZE = 2048;
+	// the waveform view spans +-12 V, the spectrum 96 dB down from a 5 V sine
+	static constexpr float RANGE = 12.f;
+	static constexpr float SPECTRUM_RANGE = 96.f;
+
+	SubharmonicGenerator* module = nullptr;
+	ScopeHistory history;
+	// UI frames since the display was drawn
+	int undrawnFrames = 0;
+	// the tap settings the history was drained with
+	bool tapping = false;
+	int decimation = 0;
+	int vco = 0;
+
+	dsp::RealFFT fft;
+	alignas(16) float fftIn[FFT_SIZE];
+	alignas(16) float fftOut[FFT_SIZE];
+	float fftWindow[FFT_SIZE];
+
+	ScopeDisplay() : fft(FFT_SIZE) {
+		for (int i = 0; i < FFT_SIZE; i++)
+			fftWindow[i] = 0.5f - 0.5f * std::cos(2.f * (float) M_PI * i / FFT_SIZE);
+	}
 
-		oscillators[0].dutyCycle = 0.5f;
-		oscillators[1].dutyCycle = 0.5f;
+	void step() override {
+		if (module) {
+			history.drain(module->scope);
+
+			undrawnFrames++;
+			bool on = module->scopeDisplay && undrawnFrames < 2;
+			// the spectrum is taken from every sample
+			int d = module->scopeView == SubharmonicGenerator::SCOPE_SPECTRUM ? 1 : 1 << module->scopeTimeBase;
+			if (on != tapping || d != decimation || module->scopeVco != vco) {
+				history.clear();
+				tapping = on;
+				decimation = d;
+				vco = module->scopeVco;
+				module->scope.decimation = decimation;
+				module->scope.vco = vco;
+				module->scope.enabled = tapping;
+			}
+		}
 
-		if (inputs[VCO1_PWM_INPUT].isConnected()) 
-			oscillators[0].dutyCycle = vco1_pwm;
+		LedDisplay::step();
+	}
 
-		if (inputs[VCO2_PWM_INPUT].isConnected()) 
-			oscillators[1].dutyCycle = vco2_pwm;
+	void draw(const DrawArgs& args) override {
+		undrawnFrames = 0;
+		LedDisplay::draw(args);
+	}
 
+	// the traces are drawn on the light layer, so they stay bright in a dimmed room
+	void drawLayer(const DrawArgs& args, int layer) override {
+		if (layer == 1 && module && tapping) {
+			nvgScissor(args.vg, 0.f, 0.f, box.size.x, box.size.y);
+			if (module->scopeView == SubharmonicGenerator::SCOPE_SPECTRUM)
+				drawSpectrum(args);
+			else
+				drawWaveforms(args);
+			nvgResetScissor(args.vg);
+		}
 
-		for (int i = 0; i < 4; i++) {
-			dividers[i].setN(std::floor(params[SUB_PARAM + i].getValue()));
-			dividers[i].setMaxN(16);
+		LedDisplay::drawLayer(args, layer);
+	}
 
-			if (i < 2) {
-				if (inputs[VCO1_INPUT].isConnected()) {
-					oscillators[i].freq = quantize(params[OSC_PARAM + i].getValue() * vco1_cv,(int) params[QUANTIZE_PARAM].getValue());
-				} else if (inputs[VCO2_INPUT].isConnected() and i == 1) {
-					oscillators[i].freq = quantize(params[OSC_PARAM + i].getValue() * vco2_cv,(int) params[QUANTIZE_PARAM].getValue());
-				}
-				else {
-					oscillators[i].freq = quantize(params[OSC_PARAM + i].getValue(), (int) params[QUANTIZE_PARAM].getValue());
-				}
-		
-				oscillators[i].process(args.sampleTime);
-			}
-		}
+	// a trace is drawn while its output is patched
+	bool shown(int trace) {
+		int output = SubharmonicGenerator::TOTAL_OUTPUT;
+		if (trace == SCOPE_VCO)
+			output = module->oscOutputs[vco];
+		else if (trace != SCOPE_TOTAL)
+			output = module->subOutputs[SubharmonicGenerator::SUBS * vco + trace - SCOPE_SUB1];
+		return module->outputs[output].isConnected();
+	}
 
-		if (inputs[VCO1_SUB_INPUT].isConnected()) {
-			dividers[0].setN(vco1_sub_cv);
-			dividers[1].setN(vco1_sub_cv);
-		}
+	void stroke(const DrawArgs& args, int trace) {
+		static const NVGcolor colors[SCOPE_TRACES_LEN] = {SCHEME_YELLOW, SCHEME_BLUE, SCHEME_GREEN, SCHEME_WHITE};
+		nvgStrokeColor(args.vg, colors[trace]);
+		nvgStrokeWidth(args.vg, 1.f);
+		nvgLineJoin(args.vg, NVG_ROUND);
+		nvgStroke(args.vg);
+	}
 
-		if (inputs[VCO2_SUB_INPUT].isConnected()) {
-			dividers[2].setN(vco2_sub_cv);
-			dividers[3].setN(vco2_sub_cv);
+	// the last window of frames that starts on a rising zero crossing of the trigger
+	// trace, or the newest window when free running or there is none
+	void drawWaveforms(const DrawArgs& args) {
+		if (history.filled < WINDOW)
+			return;
+		int start = WINDOW - 1;
+		if (module->scopeTrigger != SubharmonicGenerator::SCOPE_FREE_RUN) {
+			int age = history.trigger(module->scopeTrigger, WINDOW - 1);
+			if (age >= 0)
+				start = age;
 		}
 
-		// Set outputs based on osc1 switch
-		float osc1 = oscillators[0].sqr();
-		float sub11 = boolToAudio(dividers[0].process(osc1));
-		float sub12 = boolToAudio(dividers[1].process(osc1));
-		float out = 0.f;
-		switch ((int) params[WAVEFORM_PARAM].getValue()) {
-			case 0:
-				outputs[VCO1_OUTPUT].setVoltage(converters[0].toSaw(osc1, oscillators[0].freq, args.sampleTime) * params[OSC_LEVEL_PARAM].getValue());
-				outputs[VCO1_SUB1_OUTPUT].setVoltage(converters[1].toSaw(sub11, oscillators[0].freq / dividers[0].N, args.sampleTime) * params[SUB_LEVEL_PARAM].getValue());
-				outputs[VCO1_SUB2_OUTPUT].setVoltage(converters[2].toSaw(sub12, oscillators[0].freq / dividers[1].N, args.sampleTime) * params[SUB_LEVEL_PARAM + 1].getValue());
-				break;
-			case 1:
-				outputs[VCO1_OUTPUT].setVoltage(osc1 * params[OSC_LEVEL_PARAM].getValue());
-				outputs[VCO1_SUB1_OUTPUT].setVoltage(converters[1].toSaw(sub11, oscillators[0].freq / dividers[0].N, args.sampleTime) * params[SUB_LEVEL_PARAM].getValue());
-				outputs[VCO1_SUB2_OUTPUT].setVoltage(converters[2].toSaw(sub12, oscillators[0].freq / dividers[1].N, args.sampleTime) * params[SUB_LEVEL_PARAM + 1].getValue());
-				break;
-			case 2:
-				outputs[VCO1_OUTPUT].setVoltage(osc1 * params[OSC_LEVEL_PARAM].getValue());
-				outputs[VCO1_SUB1_OUTPUT].setVoltage(sub11 * params[SUB_LEVEL_PARAM].getValue());
-				outputs[VCO1_SUB2_OUTPUT].setVoltage(sub12 * params[SUB_LEVEL_PARAM + 1].getValue());
-				break;
+		for (int t = 0; t < SCOPE_TRACES_LEN; t++) {
+			if (!shown(t))
+				continue;
+			nvgBeginPath(args.vg);
+			for (int i = 0; i < WINDOW; i++) {
+				float x = box.size.x * i / (WINDOW - 1);
+				float y = box.size.y * (0.5f - 0.5f * history.at(t, start - i) / RANGE);
+				if (i == 0)
+					nvgMoveTo(args.vg, x, y);
+				else
+					nvgLineTo(args.vg, x, y);
+			}
+			stroke(args, t);
 		}
+	}
 
-		// Set outputs based on osc2 switch
-		float osc2 = oscillators[1].sqr();
-		float sub21 = boolToAudio(dividers[2].process(osc2));
-		float sub22 = boolToAudio(dividers[3].process(osc2));
-		switch ((int) params[WAVEFORM_PARAM + 1].getValue()) {
-			case 0:
-				outputs[VCO2_OUTPUT].setVoltage(converters[3].toSaw(oscillators[1].sqr(), oscillators[1].freq, args.sampleTime) * params[OSC_LEVEL_PARAM + 1].getValue());
-				outputs[VCO2_SUB1_OUTPUT].setVoltage(converters[4].toSaw(sub21, oscillators[1].freq / dividers[2].N, args.sampleTime) * params[SUB_LEVEL_PARAM + 2].getValue());
-				outputs[VCO2_SUB2_OUTPUT].setVoltage(converters[5].toSaw(sub22, oscillators[1].freq / dividers[3].N, args.sampleTime) * params[SUB_LEVEL_PARAM + 3].getValue());
-				break;
-			case 1:
-				outputs[VCO2_OUTPUT].setVoltage(oscillators[1].sqr() * params[OSC_LEVEL_PARAM + 1].getValue());
-				outputs[VCO2_SUB1_OUTPUT].setVoltage(converters[4].toSaw(sub21, oscillators[1].freq / dividers[2].N, args.sampleTime) * params[SUB_LEVEL_PARAM + 2].getValue());
-				outputs[VCO2_SUB2_OUTPUT].setVoltage(converters[5].toSaw(sub22, oscillators[1].freq / dividers[3].N, args.sampleTime) * params[SUB_LEVEL_PARAM + 3].getValue());
-				break;
-			case 2:
-				outputs[VCO2_OUTPUT].setVoltage(osc2 * params[OSC_LEVEL_PARAM + 1].getValue());
-				outputs[VCO2_SUB1_OUTPUT].setVoltage(sub21 * params[SUB_LEVEL_PARAM + 2].getValue());
-				outputs[VCO2_SUB2_OUTPUT].setVoltage(sub22 * params[SUB_LEVEL_PARAM + 3].getValue());
-				break;
-
+	// magnitudes of the newest frames through a Hann window, on a log frequency axis
+	// from 20 Hz to half the sample rate
+	void drawSpectrum(const DrawArgs& args) {
+		if (history.filled < FFT_SIZE)
+			return;
+		float binHz = APP->engine->getSampleRate() / FFT_SIZE;
+		float minOctave = std::log2(20.f);
+		float octaves = std::log2(binHz * FFT_SIZE / 2) - minOctave;
+		// a sine's peak bin is its amplitude times a quarter of the length
+		float fullScale = 5.f * FFT_SIZE / 4;
+
+		for (int t = 0; t < SCOPE_TRACES_LEN; t++) {
+			if (!shown(t))
+				continue;
+			for (int i = 0; i < FFT_SIZE; i++)
+				fftIn[i] = fftWindow[i] * history.at(t, FFT_SIZE - 1 - i);
+			fft.rfft(fftIn, fftOut);
+
+			nvgBeginPath(args.vg);
+			bool first = true;
+			for (int k = (int) std::ceil(20.f / binHz); k < FFT_SIZE / 2; k++) {
+				float power = fftOut[2 * k] * fftOut[2 * k] + fftOut[2 * k + 1] * fftOut[2 * k + 1];
+				float db = 10.f * std::log10(std::max(power, 1e-12f) / (fullScale * fullScale));
+				float x = box.size.x * (std::log2(k * binHz) - minOctave) / octaves;
+				float y = box.size.y * clamp(-db / SPECTRUM_RANGE, 0.f, 1.f);
+				if (first)
+					nvgMoveTo(args.vg, x, y);
+				else
+					nvgLineTo(args.vg, x, y);
+				first = false;
+			}
+			stroke(args, t);
 		}
-
-		// accumulate output voltage
-		out += outputs[VCO1_OUTPUT].getVoltage();
-		out += outputs[VCO2_OUTPUT].getVoltage();
-		out += outputs[VCO1_SUB1_OUTPUT].getVoltage();
-		out += outputs[VCO1_SUB2_OUTPUT].getVoltage();
-		out += outputs[VCO2_SUB1_OUTPUT].getVoltage();
-		out += outputs[VCO2_SUB2_OUTPUT].getVoltage();
-
-		outputs[TOTAL_OUTPUT].setVoltage(clamp(out, -11.2f, 11.2f));
 	}
 };
 
-
 struct SubharmonicGeneratorWidget : ModuleWidget {
+	// everything the profiler has handed over since it was switched on or reset
+	ProfileTotals profile;
+
 	SubharmonicGeneratorWidget(SubharmonicGenerator* module) {
 		setModule(module);
 		setPanel(createPanel(asset::plugin(pluginInstance, "res/SubharmonicGenerator.svg")));
@@ -254,25 +293,210 @@ struct SubharmonicGeneratorWidget : ModuleWidget {
 		addParam(createParamCentered<RoundBlackKnob>(mm2px(Vec(65.325, 107.209)), module, SubharmonicGenerator::SUB_LEVEL_PARAM + 2));
 		addParam(createParamCentered<RoundBlackKnob>(mm2px(Vec(93.183, 107.209)), module, SubharmonicGenerator::SUB_LEVEL_PARAM + 3));
 
-		addInput(createInputCentered<PJ301MPort>(mm2px(Vec(131.478, 28.285)), module, SubharmonicGenerator::VCO1_INPUT));
-		addInput(createInputCentered<PJ301MPort>(mm2px(Vec(149.434, 28.285)), module, SubharmonicGenerator::VCO1_SUB_INPUT));
-		addInput(createInputCentered<PJ301MPort>(mm2px(Vec(167.391, 28.285)), module, SubharmonicGenerator::VCO1_PWM_INPUT));
-		addInput(createInputCentered<PJ301MPort>(mm2px(Vec(113.522, 80.901)), module, SubharmonicGenerator::VCO2_INPUT));
-		addInput(createInputCentered<PJ301MPort>(mm2px(Vec(131.478, 80.901)), module, SubharmonicGenerator::VCO2_SUB_INPUT));
-		addInput(createInputCentered<PJ301MPort>(mm2px(Vec(149.434, 80.901)), module, SubharmonicGenerator::VCO2_PWM_INPUT));
-
-		addOutput(createOutputCentered<PJ301MPort>(mm2px(Vec(113.522, 54.593)), module, SubharmonicGenerator::VCO1_OUTPUT));
-		addOutput(createOutputCentered<PJ301MPort>(mm2px(Vec(131.478, 54.593)), module, SubharmonicGenerator::VCO1_SUB1_OUTPUT));
-		addOutput(createOutputCentered<PJ301MPort>(mm2px(Vec(149.434, 54.593)), module, SubharmonicGenerator::VCO1_SUB2_OUTPUT));
-		addOutput(createOutputCentered<PJ301MPort>(mm2px(Vec(167.391, 54.593)), module, SubharmonicGenerator::TOTAL_OUTPUT));
-		addOutput(createOutputCentered<PJ301MPort>(mm2px(Vec(113.522, 107.209)), module, SubharmonicGenerator::VCO2_OUTPUT));
-		addOutput(createOutputCentered<PJ301MPort>(mm2px(Vec(131.478, 107.209)), module, SubharmonicGenerator::VCO2_SUB1_OUTPUT));
-		addOutput(createOutputCentered<PJ301MPort>(mm2px(Vec(149.434, 107.209)), module, SubharmonicGenerator::VCO2_SUB2_OUTPUT));
+		// inputs above the outputs for each VCO, FM under its pitch and sub CV
+		addInput(createInputCentered<PJ301MPort>(mm2px(Vec(113.522, 22.5)), module, SubharmonicGenerator::VCO1_INPUT));
+		addInput(createInputCentered<PJ301MPort>(mm2px(Vec(131.478, 22.5)), module, SubharmonicGenerator::VCO1_SUB_INPUT));
+		addInput(createInputCentered<PJ301MPort>(mm2px(Vec(149.434, 22.5)), module, SubharmonicGenerator::VCO1_PWM_INPUT));
+		addInput(createInputCentered<PJ301MPort>(mm2px(Vec(167.391, 22.5)), module, SubharmonicGenerator::SYNC_INPUT));
+		addInput(createInputCentered<PJ301MPort>(mm2px(Vec(113.522, 42.3)), module, SubharmonicGenerator::EXP_FM_INPUT));
+		addInput(createInputCentered<PJ301MPort>(mm2px(Vec(131.478, 42.3)), module, SubharmonicGenerator::LIN_FM_INPUT));
+		addInput(createInputCentered<PJ301MPort>(mm2px(Vec(167.391, 42.3)), module, SubharmonicGenerator::CLOCK_INPUT));
+		addInput(createInputCentered<PJ301MPort>(mm2px(Vec(113.522, 77.5)), module, SubharmonicGenerator::VCO2_INPUT));
+		addInput(createInputCentered<PJ301MPort>(mm2px(Vec(131.478, 77.5)), module, SubharmonicGenerator::VCO2_SUB_INPUT));
+		addInput(createInputCentered<PJ301MPort>(mm2px(Vec(149.434, 77.5)), module, SubharmonicGenerator::VCO2_PWM_INPUT));
+		addInput(createInputCentered<PJ301MPort>(mm2px(Vec(167.391, 77.5)), module, SubharmonicGenerator::SYNC_INPUT + 1));
+		addInput(createInputCentered<PJ301MPort>(mm2px(Vec(113.522, 97.3)), module, SubharmonicGenerator::EXP_FM_INPUT + 1));
+		addInput(createInputCentered<PJ301MPort>(mm2px(Vec(131.478, 97.3)), module, SubharmonicGenerator::LIN_FM_INPUT + 1));
+
+		addOutput(createOutputCentered<PJ301MPort>(mm2px(Vec(113.522, 57.7)), module, SubharmonicGenerator::VCO1_OUTPUT));
+		addOutput(createOutputCentered<PJ301MPort>(mm2px(Vec(131.478, 57.7)), module, SubharmonicGenerator::VCO1_SUB1_OUTPUT));
+		addOutput(createOutputCentered<PJ301MPort>(mm2px(Vec(149.434, 57.7)), module, SubharmonicGenerator::VCO1_SUB2_OUTPUT));
+		addOutput(createOutputCentered<PJ301MPort>(mm2px(Vec(167.391, 57.7)), module, SubharmonicGenerator::TOTAL_OUTPUT));
+		addOutput(createOutputCentered<PJ301MPort>(mm2px(Vec(113.522, 112.7)), module, SubharmonicGenerator::VCO2_OUTPUT));
+		addOutput(createOutputCentered<PJ301MPort>(mm2px(Vec(131.478, 112.7)), module, SubharmonicGenerator::VCO2_SUB1_OUTPUT));
+		addOutput(createOutputCentered<PJ301MPort>(mm2px(Vec(149.434, 112.7)), module, SubharmonicGenerator::VCO2_SUB2_OUTPUT));
+		addOutput(createOutputCentered<PJ301MPort>(mm2px(Vec(167.391, 112.7)), module, SubharmonicGenerator::TOTAL_RIGHT_OUTPUT));
 
 		addParam(createParamCentered<CKSSThree>(mm2px(Vec(11.026, 28.285)), module, SubharmonicGenerator::WAVEFORM_PARAM));
 		addParam(createParamCentered<CKSSThree>(mm2px(Vec(93.183, 28.285)), module, SubharmonicGenerator::WAVEFORM_PARAM + 1));
 
 		addParam(createParamCentered<PushButton5>(mm2px(Vec(52.1, 85)), module, SubharmonicGenerator::QUANTIZE_PARAM));
+
+		// between the title and the sub knobs
+		ScopeDisplay* display = createWidget<ScopeDisplay>(mm2px(Vec(41.1, 18.5)));
+		display->box.size = mm2px(Vec(27.0, 25.0));
+		display->module = module;
+		addChild(display);
+	}
+
+	void appendContextMenu(Menu* menu) override {
+		SubharmonicGenerator* module = getModule<SubharmonicGenerator>();
+
+		menu->addChild(new MenuSeparator);
+
+		static const std::vector<int> controlRates = {1, 16, 32, 64};
+		menu->addChild(createIndexSubmenuItem("Control rate", {"Every sample", "Every 16 samples", "Every 32 samples", "Every 64 samples"},
+			[=]() {
+				auto it = std::find(controlRates.begin(), controlRates.end(), module->controlRate);
+				return it == controlRates.end() ? 0 : it - controlRates.begin();
+			},
+			[=](size_t i) {
+				module->setControlRate(controlRates[i]);
+			}
+		));
+
+		menu->addChild(createIndexPtrSubmenuItem("Sub oscillators", {"Edge counted", "Phase locked", "Clocked rhythms"}, &module->dividerMode));
+		menu->addChild(createIndexPtrSubmenuItem("Rhythm outputs", {"Gates", "Triggers"}, &module->rhythmOutput));
+		menu->addChild(createIndexPtrSubmenuItem("Division changes", {"At the next master cycle", "At the next sub cycle", "Rescale the phase now"}, &module->divisionChange));
+		menu->addChild(createBoolPtrMenuItem("Division hysteresis", "", &module->divisionHysteresis));
+
+		menu->addChild(createSubmenuItem("Wavetable", "", [=](Menu* menu) {
+			menu->addChild(createIndexPtrSubmenuItem("Shape", {"Off", "Saw", "Square", "Triangle", "Morph"}, &module->wavetable));
+			menu->addChild(new SettingSlider(&module->wavetableMorph, 0.5f, "Morph"));
+		}));
+
+		menu->addChild(createSubmenuItem("Mix", "", [=](Menu* menu) {
+			menu->addChild(createIndexPtrSubmenuItem("Saturation", {"Hard clip", "Soft clip"}, &module->mixSaturation));
+			menu->addChild(createBoolPtrMenuItem("DC blocker", "", &module->mixDcBlocker));
+			menu->addChild(new SettingSlider(&module->stereoSpread, 0.f, "Stereo spread"));
+		}));
+
+		static const std::vector<int> oversampleFactors = {1, 2, 4, 8};
+		menu->addChild(createIndexSubmenuItem("Oversampling", {"Off", "2x", "4x", "8x"},
+			[=]() {
+				auto it = std::find(oversampleFactors.begin(), oversampleFactors.end(), module->oversample);
+				return it == oversampleFactors.end() ? 0 : it - oversampleFactors.begin();
+			},
+			[=](size_t i) {
+				module->setOversample(oversampleFactors[i]);
+			}
+		));
+
+		// Scala files are read, parsed and built here on the UI thread, the audio thread
+		// only picks up the finished table
+		std::string tuningName = module->scalaText.empty() ? "Built in" : module->scalaName;
+		menu->addChild(createSubmenuItem("Tuning", tuningName, [=](Menu* menu) {
+			menu->addChild(createMenuItem("Load Scala scale (.scl)...", "", [=]() {
+				std::string path, text, error;
+				if (!chooseTextFile("Scala scale (.scl):scl", path, text))
+					return;
+				if (!module->setTuning(text, module->mappingText, error)) {
+					showTuningError(path, error);
+					return;
+				}
+				module->scalaName = system::getFilename(path);
+			}));
+
+			menu->addChild(createMenuItem("Load keyboard mapping (.kbm)...", module->mappingName, [=]() {
+				std::string path, text, error;
+				if (!chooseTextFile("Scala keyboard mapping (.kbm):kbm", path, text))
+					return;
+				if (!module->setTuning(module->scalaText, text, error)) {
+					showTuningError(path, error);
+					return;
+				}
+				module->mappingName = system::getFilename(path);
+			}, module->scalaText.empty()));
+
+			menu->addChild(createMenuItem("Clear keyboard mapping", "", [=]() {
+				std::string error;
+				if (module->setTuning(module->scalaText, "", error))
+					module->mappingName.clear();
+			}, module->mappingText.empty()));
+
+			menu->addChild(createMenuItem("Use built in tunings", "", [=]() {
+				module->clearTuning();
+			}, module->scalaText.empty()));
+		}));
+
+		menu->addChild(createSubmenuItem("Unison", module->unison > 1 ? string::f("%d voices", module->unison) : "Off", [=](Menu* menu) {
+			menu->addChild(createIndexSubmenuItem("Voices", {"Off", "2", "3", "4", "5", "6", "7", "8"},
+				[=]() {
+					return module->unison - 1;
+				},
+				[=](size_t i) {
+					module->unison = i + 1;
+				}
+			));
+			menu->addChild(new SettingSlider(&module->unisonDetune, 0.f, "Detune"));
+			menu->addChild(new SettingSlider(&module->unisonSpread, 0.f, "Stereo spread"));
+		}));
+
+		menu->addChild(createSubmenuItem("Scope", module->scopeDisplay ? "On" : "Off", [=](Menu* menu) {
+			menu->addChild(createBoolPtrMenuItem("Display", "", &module->scopeDisplay));
+			menu->addChild(createIndexPtrSubmenuItem("View", {"Waveforms", "Spectrum"}, &module->scopeView));
+			menu->addChild(createIndexPtrSubmenuItem("VCO", {"VCO1", "VCO2"}, &module->scopeVco));
+			menu->addChild(createIndexPtrSubmenuItem("Trigger", {"VCO", "Sub 1", "Sub 2", "TOTAL", "Free running"}, &module->scopeTrigger));
+
+			// the waveform view's width at the engine's sample rate
+			std::vector<std::string> timeBases;
+			for (int i = 0; i < SubharmonicGenerator::SCOPE_TIME_BASES_LEN; i++)
+				timeBases.push_back(string::f("%.1f ms", 1e3f * (ScopeDisplay::WINDOW << i) / APP->engine->getSampleRate()));
+			menu->addChild(createIndexPtrSubmenuItem("Time base", timeBases, &module->scopeTimeBase));
+		}));
+
+		// the figures are a snapshot taken as the menu opens
+		bool profiling = module->profiler.enabled;
+		std::string usage = "Off";
+		if (profiling && !profile.calibrated())
+			usage = "Calibrating";
+		else if (profiling && profile.all.calls > 0)
+			usage = string::f("%.2f%% CPU", corePercent(profile.nanoseconds((double) profile.all.ticks / profile.all.calls)));
+		menu->addChild(createSubmenuItem("Instrumentation", usage, [=](Menu* menu) {
+			menu->addChild(createBoolMenuItem("Time process() calls", "",
+				[=]() {
+					return module->profiler.enabled.load();
+				},
+				[=](bool enabled) {
+					module->profiler.restart();
+					profile.clear();
+					module->profiler.enabled = enabled;
+				}
+			));
+			menu->addChild(createMenuItem("Reset", "", [=]() {
+				module->profiler.restart();
+				profile.clear();
+			}, !profiling));
+			menu->addChild(createMenuItem("Save CSV...", "", [=]() {
+				saveProfileCsv(profile);
+			}, profile.all.calls == 0 || !profile.calibrated()));
+
+			if (profile.all.calls == 0)
+				return;
+			if (!profile.calibrated()) {
+				menu->addChild(new MenuSeparator);
+				menu->addChild(createMenuLabel("Calibrating the timer, reopen the menu"));
+				return;
+			}
+
+			double mean = profile.nanoseconds((double) profile.all.ticks / profile.all.calls);
+			menu->addChild(new MenuSeparator);
+			menu->addChild(createMenuLabel(string::f("%llu calls, %.0f ns mean, %.1f us worst", (unsigned long long) profile.all.calls, mean, profile.nanoseconds(profile.all.worstTicks) * 1e-3)));
+			menu->addChild(createMenuLabel(string::f("%.2f%% of one core at %.0f Hz", corePercent(mean), APP->engine->getSampleRate())));
+			if (profile.dropped > 0)
+				menu->addChild(createMenuLabel(string::f("%u records dropped", profile.dropped)));
+
+			// the most expensive paths, by their share of the total time
+			menu->addChild(new MenuSeparator);
+			std::vector<ProcessStats> paths = sortedPaths(profile);
+			for (size_t i = 0; i < paths.size() && i < 8; i++) {
+				const ProcessStats& stats = paths[i];
+				menu->addChild(createMenuLabel(string::f("%4.1f%%  %s  %.0f ns mean, %.1f us worst",
+					100.0 * stats.ticks / profile.all.ticks, SubharmonicGenerator::describeProfilePath(stats.path).c_str(),
+					profile.nanoseconds((double) stats.ticks / stats.calls), profile.nanoseconds(stats.worstTicks) * 1e-3)));
+			}
+		}));
+	}
+
+	void step() override {
+		// free tunings the audio thread has finished with
+		SubharmonicGenerator* module = getModule<SubharmonicGenerator>();
+		if (module) {
+			module->tuning.collect();
+			profile.drain(module->profiler);
+		}
+
+		ModuleWidget::step();
 	}
 };
 
@@ -0,0 +1,1655 @@
+#pragma once
+#include <rack.hpp>
+#include <cmath>
+
+using namespace rack;
+using simd::float_4;
+
+#include "inc/RealtimeGuard.hpp"
+#include "inc/Utility.hpp"
+#include "inc/BandLimit.hpp"
+#include "inc/WaveformConverter.hpp"
+#include "inc/FrequencyDivider.hpp"
+#include "inc/PhaseDivider.hpp"
+#include "inc/Oversample.hpp"
+#include "inc/GateProcessor.hpp"
+#include "inc/Quantize.cpp"
+#include "inc/Scala.hpp"
+#include "inc/Instrumentation.hpp"
+#include "inc/Wavetable.hpp"
+#include "inc/MixBus.hpp"
+#include "inc/VoiceBus.hpp"
+#include "inc/Scope.hpp"
+
+// T is a simd vector type such as simd::float_4, one voice per lane
+template <typename T>
+struct SquareWaveGenerator {
+	T phase = 0.f;
+	T freq = 0.f;
+	T dutyCycle = 0.5f;
+
+	MinBlep<T> sqrMinBlep;
+
+	// the naive square drives the dividers and converters, edgeP is the position
+	// of its latest edge relative to the current frame
+	T naiveSqr = 0.f;
+	T edgeP = 0.f;
+	T sqrValue = 0.f;
+
+	// phase increment and edges of the latest frame, read by the phase dividers
+	T deltaPhase = 0.f;
+	T rise = 0.f;
+	T riseP = 0.f;
+	T fall = 0.f;
+	T fallP = 0.f;
+
+	// advance the phase and the naive square by one frame. THROUGH_ZERO lets a
+	// negative frequency run the phase backwards, rise and fall then mark where the
+	// phase wraps and crosses the duty cycle in either direction
+	template <bool THROUGH_ZERO = false>
+	ALWAYS_INLINE void advance(float deltaTime) {
+		// Advance phase
+		deltaPhase = simd::clamp(freq * deltaTime, THROUGH_ZERO ? -0.35f : 0.f, 0.35f);
+		T oldPhase = phase;
+
+		phase += deltaPhase;
+
+		if (THROUGH_ZERO) {
+			// backwards, the phase wraps through 0 and meets the duty cycle from above
+			T backward = deltaPhase < 0.f;
+			rise = simd::ifelse(backward, phase < 0.f, phase >= 1.f);
+			riseP = (simd::ifelse(backward, 0.f, 1.f) - phase) / deltaPhase;
+
+			T fallPhase = simd::ifelse(backward,
+				simd::ifelse(oldPhase >= dutyCycle, dutyCycle, dutyCycle - 1.f),
+				simd::ifelse(oldPhase < dutyCycle, dutyCycle, dutyCycle + 1.f));
+			fall = simd::ifelse(backward, phase < fallPhase, phase >= fallPhase);
+			fallP = (fallPhase - phase) / deltaPhase;
+		}
+		else {
+			// rising edge where the phase wraps
+			rise = phase >= 1.f;
+			riseP = (1.f - phase) / deltaPhase;
+
+			// falling edge where the phase crosses the duty cycle, before or after wrapping
+			T fallPhase = simd::ifelse(oldPhase < dutyCycle, dutyCycle, dutyCycle + 1.f);
+			fall = phase >= fallPhase;
+			fallP = (fallPhase - phase) / deltaPhase;
+		}
+
+		// Wrap phase to stay within [0, 1]
+		phase -= simd::floor(phase);
+
+		naiveSqr = simd::ifelse(phase < dutyCycle, 5.f, -5.f);
+		edgeP = simd::ifelse(fall, fallP, riseP);
+	}
+
+	// Hard sync after advance(), the lanes in mask restart their cycle at p in the frame.
+	// Running backwards a lane restarts from the top of its cycle. The frame's own edges
+	// in those lanes are dropped, and edgeP is the reset's. returns the step the naive
+	// square takes at the reset, for the caller to band limit
+	template <bool THROUGH_ZERO = false>
+	ALWAYS_INLINE T reset(T mask, T p) {
+		// the square as the reset came
+		T before = phase + p * deltaPhase;
+		before -= simd::floor(before);
+		T sqrBefore = simd::ifelse(before < dutyCycle, 5.f, -5.f);
+
+		T start = THROUGH_ZERO ? simd::ifelse(deltaPhase < 0.f, 1.f, 0.f) : T(0.f);
+		phase = simd::ifelse(mask, start - p * deltaPhase, phase);
+		naiveSqr = simd::ifelse(phase < dutyCycle, 5.f, -5.f);
+		rise = rise & ~mask;
+		fall = fall & ~mask;
+		edgeP = simd::ifelse(mask, p, edgeP);
+		return simd::ifelse(mask, naiveSqr - sqrBefore, 0.f);
+	}
+
+	// advance one frame and band limit the square, with minBLEP corrections at both edges
+	template <bool THROUGH_ZERO = false>
+	ALWAYS_INLINE void process(float deltaTime) {
+		advance<THROUGH_ZERO>(deltaTime);
+		bandLimit<THROUGH_ZERO>();
+	}
+
+	// band limit the square's edges in the latest frame
+	template <bool THROUGH_ZERO = false>
+	ALWAYS_INLINE void bandLimit() {
+		// running backwards each edge steps the other way
+		T step = THROUGH_ZERO ? simd::ifelse(deltaPhase < 0.f, -10.f, 10.f) : T(10.f);
+		insertDiscontinuities(sqrMinBlep, rise, riseP, step);
+		insertDiscontinuities(sqrMinBlep, fall, fallP, -step);
+		sqrValue = naiveSqr + sqrMinBlep.process();
+	}
+
+	// advance a number of frames in one step, which may differ by lane, and count the
+	// square's edges on the way
+	void skip(float deltaTime, T frames, T& rises, T& falls) {
+		deltaPhase = simd::clamp(freq * deltaTime, 0.f, 0.35f);
+		T end = phase + deltaPhase * frames;
+
+		// the square falls each time the phase passes the duty cycle
+		rises = simd::floor(end);
+		falls = simd::floor(end - dutyCycle) - simd::floor(phase - dutyCycle);
+
+		phase = end - rises;
+		naiveSqr = simd::ifelse(phase < dutyCycle, 5.f, -5.f);
+		rise = fall = 0.f;
+	}
+
+	T sqr() {
+		return sqrValue;
+	}
+
+};
+
+// A sub oscillator for a group of four channels. It holds the dividers for both sub
+// modes, so a mode change keeps each one's place
+struct SubVoice {
+	TFrequencyDivider<float_4> divider;
+	PhaseDivider<float_4> phaseDivider;
+	BandLimitedSquare<float_4> square;
+	WaveformConverter<float_4> saw;
+
+	// division step held by the hysteresis and whether it has been read from the sub CV yet,
+	// and the time left on a rhythm trigger
+	float_4 heldDivision = 0.f;
+	bool divisionHeld = false;
+	float_4 triggerTime = 0.f;
+};
+
+// A VCO and its subs for a group of four lanes, one per channel or unison copy. The module
+// keeps these in a single bank ordered by channel group, so a kernel works through
+// one block of memory instead of gathering from an array for each type
+template <int SUBS>
+struct VcoVoice {
+	SquareWaveGenerator<float_4> osc;
+	WaveformConverter<float_4> saw;
+	SubVoice subs[SUBS];
+
+	// the edge counted subs all count the VCO's square, so they share its gate
+	TGateProcessor<float_4> sqrGate;
+
+	// Hard sync, read once per host sample. syncTime is when a reset is due, in kernel
+	// frames from the start of the next one, and below -1 once it is past. While the
+	// VCO is idle, syncAge counts kernel frames since its latest reset instead, -1 for none
+	TGateProcessor<float_4> syncGate;
+	float_4 lastSync = 0.f;
+	float_4 syncTime = -2.f;
+	float_4 syncAge = -1.f;
+};
+
+
+struct SubharmonicGenerator : Module {
+	enum ParamId {
+		ENUMS(OSC_PARAM, 2),
+		ENUMS(SUB_PARAM, 4),
+		ENUMS(OSC_LEVEL_PARAM, 2),
+		ENUMS(SUB_LEVEL_PARAM, 4),
+		ENUMS(WAVEFORM_PARAM, 2),
+		QUANTIZE_PARAM,
+		PARAMS_LEN
+	};
+	enum InputId {
+		VCO1_INPUT,
+		VCO1_SUB_INPUT,
+		VCO1_PWM_INPUT,
+		VCO2_INPUT,
+		VCO2_SUB_INPUT,
+		VCO2_PWM_INPUT,
+		ENUMS(EXP_FM_INPUT, 2),
+		ENUMS(LIN_FM_INPUT, 2),
+		CLOCK_INPUT,
+		ENUMS(SYNC_INPUT, 2),
+		INPUTS_LEN
+	};
+	enum OutputId {
+		VCO1_OUTPUT,
+		VCO1_SUB1_OUTPUT,
+		VCO1_SUB2_OUTPUT,
+		TOTAL_OUTPUT,
+		VCO2_OUTPUT,
+		VCO2_SUB1_OUTPUT,
+		VCO2_SUB2_OUTPUT,
+		TOTAL_RIGHT_OUTPUT,
+		OUTPUTS_LEN
+	};
+	enum LightId {
+		LIGHTS_LEN
+	};
+
+	// per VCO port lookups, VCO2 follows VCO1 in each list
+	const int pitchInputs[2] = {VCO1_INPUT, VCO2_INPUT};
+	const int subInputs[2] = {VCO1_SUB_INPUT, VCO2_SUB_INPUT};
+	const int pwmInputs[2] = {VCO1_PWM_INPUT, VCO2_PWM_INPUT};
+	const int oscOutputs[2] = {VCO1_OUTPUT, VCO2_OUTPUT};
+
+	// Subs per VCO. The voice bank and kernels take any count, the ports and panel have
+	// two. Sub s of the module is sub s % SUBS of VCO s / SUBS
+	static const int SUBS = 2;
+	static const int SUBS_LEN = 2 * SUBS;
+	const int subOutputs[SUBS_LEN] = {VCO1_SUB1_OUTPUT, VCO1_SUB2_OUTPUT, VCO2_SUB1_OUTPUT, VCO2_SUB2_OUTPUT};
+
+	// the voice bank, by channel group and then VCO. Voices are processed four
+	// channels at a time
+	VcoVoice<SUBS> voices[4][2];
+	Quantizer quantizers[2][16];
+
+	// the latest frame of every output, written by the audio kernels
+	float_4 frame[OUTPUTS_LEN][4];
+
+	// oversampling factor, the voices run this many times per host sample and each
+	// output is brought back to the host rate by its decimator
+	int oversample = 1;
+	int decimatorFactor = 1;
+	PolyphaseDecimator<float_4> decimators[OUTPUTS_LEN][4];
+
+	// only patched outputs are decimated, listed at control rate
+	int decimatedOutputs[OUTPUTS_LEN] = {};
+	int decimatedCount = 0;
+
+	// control rate state, refreshed by processControls(). channels counts the lanes the
+	// voices run in and outputChannels the channels of the outputs, which differ in unison
+	int channels = 1;
+	int outputChannels = 1;
+	int waveforms[2] = {};
+
+	// The level knobs set the targets, the kernels use the levels, which follow them
+	// once per host sample with a LEVEL_TIME time constant. A level snaps to its knob
+	// the first time the controls are read
+	static constexpr float LEVEL_TIME = 5e-3f;
+	float oscLevels[2] = {};
+	float subLevels[SUBS_LEN] = {};
+	float oscLevelTargets[2] = {};
+	float subLevelTargets[SUBS_LEN] = {};
+	float levelCoefficient = 1.f;
+	bool levelsSettled = true;
+	bool snapLevels = true;
+
+	// Whether each output is heard, refreshed at control rate. A VCO or sub is skipped
+	// while its level is zero or neither its own output nor the total is patched. A
+	// VCO with nothing heard runs the idle kernel and is moved on analytically at
+	// control rate, so it wakes up in phase
+	bool oscActive[2] = {};
+	bool subActive[SUBS_LEN] = {};
+	bool vcoActive[2] = {};
+
+	// audio rate FM applied on top of the control rate pitch, and the pitch it applies
+	// to. A VCO with linear FM runs the through-zero kernels, as its frequency may
+	// go negative
+	bool expFm[2] = {};
+	bool linFm[2] = {};
+	float_4 baseFreqs[2][4] = {};
+
+	// Hard sync. A rise on a VCO's sync input restarts the VCO, its subs and their saws
+	// together, at the point between host samples where the input crossed the gate's
+	// upper threshold, with each jump band limited
+	bool sync[2] = {};
+
+	// audio kernel frames run since the last control update
+	int elapsedFrames = 0;
+
+	// parameters and CV are read once every controlRate samples
+	int controlRate = 16;
+	dsp::ClockDivider controlDivider;
+	bool controlsDirty = true;
+
+	// how the subs are derived from their VCO. In rhythm mode the four dividers count the
+	// clock input instead and the sub outputs give gates or triggers
+	enum DividerMode {
+		EDGE_COUNT_MODE,
+		PHASE_LOCK_MODE,
+		RHYTHM_MODE,
+		DIVIDER_MODES_LEN
+	};
+	int dividerMode = EDGE_COUNT_MODE;
+
+	// rhythm mode, set at control rate. Each sub output is high for the first clock of
+	// every N, or gives a trigger as that clock rises
+	enum RhythmOutput {
+		RHYTHM_GATES,
+		RHYTHM_TRIGGERS,
+		RHYTHM_OUTPUTS_LEN
+	};
+	static constexpr float TRIGGER_TIME = 1e-3f;
+	bool rhythm = false;
+	int rhythmOutput = RHYTHM_GATES;
+	// the clock's gate for each channel group, shared by the subs
+	TGateProcessor<float_4> clockGates[4];
+
+	// when the subs take up a new division, see DivisionChange
+	int divisionChange = CHANGE_AT_SUB_CYCLE;
+
+	// Division steps from the sub CV are held until it is this far into the next step, so
+	// noise on a boundary does not switch the division back and forth
+	static constexpr float DIVISION_HYSTERESIS = 0.2f;
+	bool divisionHysteresis = true;
+
+	// Wavetable oscillators. When on, every saw the waveform switches ask for, from the
+	// VCOs and the subs, is read from the shared mip-mapped tables at the saw's phase
+	// instead of band limited with minBLEPs. Morph blends triangle, saw and square
+	enum Wavetable {
+		WAVETABLE_OFF,
+		WAVETABLE_SAW,
+		WAVETABLE_SQUARE,
+		WAVETABLE_TRIANGLE,
+		WAVETABLE_MORPH,
+		WAVETABLES_LEN
+	};
+	int wavetable = WAVETABLE_OFF;
+	float wavetableMorph = 0.5f;
+	// set at control rate, the table read and the next shape and how much of it is mixed in
+	int tableShape = TABLE_SAW;
+	float tableBlend = 0.f;
+	const Wavetables* wavetables = &getWavetables();
+
+	// The TOTAL mix. The mix kernel sums each VCO and its subs from the kernels' frame
+	// with a left and a right weight per voice, set at control rate, then optionally
+	// blocks DC and soft clips instead of the hard clip at MIX_LIMIT. TOTAL is the left
+	// mix and TOTAL_RIGHT the right. The voices are spread across the pair by
+	// stereoSpread, which leaves both as the same mono mix at zero
+	enum MixSaturation {
+		MIX_HARD_CLIP,
+		MIX_SOFT_CLIP,
+		MIX_SATURATIONS_LEN
+	};
+	static constexpr float DC_BLOCKER_CUTOFF = 5.f;
+	int mixSaturation = MIX_HARD_CLIP;
+	bool mixDcBlocker = false;
+	float stereoSpread = 0.f;
+	// by side, VCO, voice and channel group, the VCO first and then its subs
+	float_4 mixWeights[2][2][1 + SUBS][4] = {};
+	DcBlocker<float_4> dcBlockers[2][4];
+	float dcCoefficient = 1.f;
+
+	// Unison. Each channel runs as unisonVoices copies in neighbouring lanes of the voice
+	// bank, each with its own subs, and every output sums the copies of its channels.
+	// The copies are spread evenly up to UNISON_DETUNE semitones either side of the
+	// pitch by unisonDetune, and across the stereo mix by unisonSpread. Copies are summed
+	// with a gain of 1 / sqrt(unisonVoices), which keeps detuned copies at about the
+	// level of one. The count is cut where the channels would need more than 16 lanes
+	static const int UNISON_MAX = 8;
+	static constexpr float UNISON_DETUNE = 0.5f;
+	int unison = 1;
+	float unisonDetune = 0.f;
+	float unisonSpread = 0.f;
+	int unisonVoices = 1;
+	float unisonGain = 1.f;
+	// the input channel each lane reads, where its copy sits among its channel's from
+	// -1 to 1, and its pitch ratio, for the count and detune they were worked out for
+	int laneChannels[16] = {};
+	float_4 laneSpans[4] = {};
+	float_4 laneRatios[4] = {1.f, 1.f, 1.f, 1.f};
+	int laneVoices = 0;
+	float laneDetune = 0.f;
+	// patched outputs other than the mix, their copies are summed after each frame
+	int foldedOutputs[OUTPUTS_LEN] = {};
+	int foldedCount = 0;
+
+	// The voice bus for a module on the right, see VoiceBus.hpp. While a reader there
+	// asks for it the VCOs are never idled, so the state it reads moves every sample
+	static_assert(SUBS_LEN == VOICE_BUS_SUBS, "the voice bus has four subs");
+	VoiceBusMessage busMessages[2];
+	bool busReader = false;
+	// the module on the right when the requests were last cleared
+	Module* busNeighbor = nullptr;
+
+	// audio kernel waveform of a VCO with nothing heard, after the switch positions
+	static const int IDLE_WAVEFORM = 3;
+
+	// the audio path and the per VCO control path run through kernels specialised on
+	// the configuration, so the per sample code has no branches on module state
+	typedef void (SubharmonicGenerator::*AudioKernel)(float sampleTime);
+	typedef void (SubharmonicGenerator::*ControlKernel)(int v, int pitchInput, const ScaleTable* scale);
+	typedef void (SubharmonicGenerator::*MixKernel)();
+	AudioKernel audioKernel = nullptr;
+	ControlKernel controlKernels[2] = {};
+	int kernelConfig = -1;
+	// null while neither mix output is patched
+	MixKernel mixKernel = nullptr;
+	int mixConfig = -1;
+
+	// a loaded Scala tuning replaces the built in tunings whenever quantize is on
+	ScaleSlot tuning;
+
+	// optional timing of every process() call, summed per audio path. The path is
+	// packed at control rate: kernel waveform of each VCO in bits 0-3, sub mode in
+	// bits 4-5, quantize mode in bits 6-8 (5 for a Scala tuning), log2 of the
+	// oversampling factor in bits 9-10, channel groups - 1 in bits 11-12 and FM on
+	// each VCO in bits 13-14, wavetables in bit 15, sync in bit 16 and unison in bit 17
+	ProcessProfiler profiler;
+	uint32_t profilePath = 0;
+
+	// The panel scope, see Scope.hpp. The settings are the UI thread's, the widget
+	// hands the audio thread what it needs through the tap, and only enables it while
+	// the display is on and drawn
+	enum ScopeView {
+		SCOPE_WAVEFORMS,
+		SCOPE_SPECTRUM,
+		SCOPE_VIEWS_LEN
+	};
+	// triggers are a ScopeTrace, or this to free run
+	static const int SCOPE_FREE_RUN = SCOPE_TRACES_LEN;
+	static const int SCOPE_TIME_BASES_LEN = 7;
+	bool scopeDisplay = false;
+	int scopeVco = 0;
+	int scopeView = SCOPE_WAVEFORMS;
+	int scopeTrigger = SCOPE_VCO;
+	// log2 of the host samples per frame in the waveform view
+	int scopeTimeBase = 2;
+	ScopeTap scope;
+
+	// the loaded files and their names, kept for dataToJson, UI thread only
+	std::string scalaText;
+	std::string scalaName;
+	std::string mappingText;
+	std::string mappingName;
+
+	SubharmonicGenerator() {
+		config(PARAMS_LEN, INPUTS_LEN, OUTPUTS_LEN, LIGHTS_LEN);
+		
+		// configure patchbay I/O
+		configInput(VCO1_INPUT, "");
+		configInput(VCO1_SUB_INPUT, "");
+		configInput(VCO1_PWM_INPUT, "");
+		configInput(VCO2_INPUT, "");
+		configInput(VCO2_SUB_INPUT, "");
+		configInput(VCO2_PWM_INPUT, "");
+		configInput(EXP_FM_INPUT, "VCO1 exponential FM");
+		configInput(EXP_FM_INPUT + 1, "VCO2 exponential FM");
+		configInput(LIN_FM_INPUT, "VCO1 linear through-zero FM");
+		configInput(LIN_FM_INPUT + 1, "VCO2 linear through-zero FM");
+		configInput(CLOCK_INPUT, "Rhythm clock");
+		configInput(SYNC_INPUT, "VCO1 sync");
+		configInput(SYNC_INPUT + 1, "VCO2 sync");
+		configOutput(VCO1_OUTPUT, "");
+		configOutput(VCO1_SUB1_OUTPUT, "");
+		configOutput(VCO1_SUB2_OUTPUT, "");
+		configOutput(TOTAL_OUTPUT, "");
+		configOutput(VCO2_OUTPUT, "");
+		configOutput(VCO2_SUB1_OUTPUT, "");
+		configOutput(VCO2_SUB2_OUTPUT, "");
+		configOutput(TOTAL_RIGHT_OUTPUT, "Total right");
+		configParam(QUANTIZE_PARAM, 0.0f, 4.0f, 0.0f, "Quantize Param");
+
+		rightExpander.producerMessage = &busMessages[0];
+		rightExpander.consumerMessage = &busMessages[1];
+
+		// configure oscillator and mixer parameters
+		for (int i = 0; i < 4; i++) {
+			configParam(SUB_PARAM + i, 1.f, 16.f, 1.f, "");
+			configParam(SUB_LEVEL_PARAM + i, 0.f, 1.f, 0.f, "");
+
+			if (i < 2) {
+				configParam(OSC_LEVEL_PARAM + i, 0.f, 1.f, 0.f, "");
+				configParam(OSC_PARAM + i, 261.63, 4186.01, 0.f, "");
+				configSwitch(WAVEFORM_PARAM + i, 0.f, 2.f, 0.f, "Waveform", {"Saw", "Square<-Saw", "Square"});
+			}
+		}
+
+		for (int g = 0; g < 4; g++) {
+			for (int v = 0; v < 2; v++) {
+				for (SubVoice& sub : voices[g][v].subs) {
+					sub.divider.setMaxN(16);
+					sub.phaseDivider.setMaxN(16);
+				}
+			}
+		}
+
+		setControlRate(controlRate);
+	}
+
+	// read parameters and CV into the voice state, run every controlRate samples.
+	// sampleTime is the audio kernel's
+	void processControls(float sampleTime) {
+		// catch idle VCOs up with the frames since the last update
+		for (int v = 0; v < 2; v++) {
+			if (!vcoActive[v] && elapsedFrames > 0)
+				skipVco(v, sampleTime, elapsedFrames);
+		}
+		elapsedFrames = 0;
+
+		// polyphony follows the widest of the two pitch inputs, each channel taking a lane
+		// for every unison copy
+		outputChannels = std::max(std::max(inputs[VCO1_INPUT].getChannels(), inputs[VCO2_INPUT].getChannels()), 1);
+		setUnison();
+		channels = outputChannels * unisonVoices;
+		int quantize = (int) params[QUANTIZE_PARAM].getValue();
+		const ScaleTable* scale = builtinScales.get(quantize);
+		const ScaleTable* userScale = tuning.acquire();
+		if (scale && userScale) {
+			scale = userScale;
+			quantize = 5;
+		}
+
+		for (int v = 0; v < 2; v++) {
+			waveforms[v] = clamp((int) params[WAVEFORM_PARAM + v].getValue(), 0, 2);
+			oscLevelTargets[v] = params[OSC_LEVEL_PARAM + v].getValue();
+		}
+		for (int s = 0; s < SUBS_LEN; s++)
+			subLevelTargets[s] = params[SUB_LEVEL_PARAM + s].getValue();
+
+		if (snapLevels) {
+			snapLevels = false;
+			std::copy(oscLevelTargets, oscLevelTargets + 2, oscLevels);
+			std::copy(subLevelTargets, subLevelTargets + SUBS_LEN, subLevels);
+		}
+		levelsSettled = false;
+		levelCoefficient = 1.f - std::exp(-sampleTime * oversample / LEVEL_TIME);
+
+		bool tables = wavetable != WAVETABLE_OFF;
+		if (wavetable == WAVETABLE_MORPH) {
+			float morph = clamp(wavetableMorph, 0.f, 1.f) * (TABLE_SHAPES_LEN - 1);
+			tableShape = std::min((int) morph, TABLE_SHAPES_LEN - 2);
+			tableBlend = morph - tableShape;
+		}
+		else {
+			static const int shapes[] = {TABLE_SAW, TABLE_SAW, TABLE_SQUARE, TABLE_TRIANGLE};
+			tableShape = shapes[tables ? wavetable : 0];
+			tableBlend = 0.f;
+		}
+
+		// the dividers start counting afresh whenever they move between the VCOs and the clock
+		bool wasRhythm = rhythm;
+		rhythm = dividerMode == RHYTHM_MODE;
+		if (rhythm != wasRhythm) {
+			for (int g = 0; g < 4; g++) {
+				clockGates[g].reset();
+				for (int v = 0; v < 2; v++) {
+					voices[g][v].sqrGate.reset();
+					for (SubVoice& sub : voices[g][v].subs) {
+						sub.divider.reset();
+						sub.triggerTime = 0.f;
+					}
+				}
+			}
+		}
+
+		// a component is heard when it has a level, or is still fading out, and its own or a
+		// mix output is patched. Anything that comes back or changes waveform is restarted
+		// once its controls are set
+		for (int v = 0; v < 2; v++) {
+			expFm[v] = inputs[EXP_FM_INPUT + v].isConnected();
+			linFm[v] = inputs[LIN_FM_INPUT + v].isConnected();
+			sync[v] = inputs[SYNC_INPUT + v].isConnected();
+		}
+
+		bool totalPatched = outputs[TOTAL_OUTPUT].isConnected() || outputs[TOTAL_RIGHT_OUTPUT].isConnected();
+		// a new neighbour has to ask for the bus itself
+		if (rightExpander.module != busNeighbor) {
+			busNeighbor = rightExpander.module;
+			for (VoiceBusMessage& message : busMessages)
+				message.reader.store(0, std::memory_order_relaxed);
+		}
+		busReader = busNeighbor && (busMessages[0].reader.load(std::memory_order_relaxed) || busMessages[1].reader.load(std::memory_order_relaxed));
+		int oldWaveforms[2] = {kernelConfig & 3, (kernelConfig >> 2) & 3};
+		bool modeChanged = ((kernelConfig >> 4) & 3) != dividerMode || ((kernelConfig >> 13) & 1) != tables;
+		bool wakeOscs[2];
+		bool wakeSubs[SUBS_LEN];
+		for (int v = 0; v < 2; v++) {
+			bool changed = modeChanged || oldWaveforms[v] != waveforms[v];
+
+			bool wasActive = oscActive[v];
+			oscActive[v] = (oscLevelTargets[v] != 0.f || oscLevels[v] != 0.f) && (totalPatched || outputs[oscOutputs[v]].isConnected());
+			wakeOscs[v] = oscActive[v] && (!wasActive || changed);
+			vcoActive[v] = oscActive[v] || busReader;
+
+			for (int s = SUBS * v; s < SUBS * (v + 1); s++) {
+				wasActive = subActive[s];
+				subActive[s] = !rhythm && (subLevelTargets[s] != 0.f || subLevels[s] != 0.f) && (totalPatched || outputs[subOutputs[s]].isConnected());
+				wakeSubs[s] = subActive[s] && (!wasActive || changed);
+				vcoActive[v] = vcoActive[v] || subActive[s];
+			}
+		}
+
+		// VCO2 pitch is normalled to the VCO1 input
+		int vcoPitchInputs[2] = {VCO1_INPUT, inputs[VCO2_INPUT].isConnected() ? VCO2_INPUT : VCO1_INPUT};
+
+		// pick new kernels only when the configuration they are specialised on changes
+		int kernelWaveforms[2];
+		for (int v = 0; v < 2; v++)
+			kernelWaveforms[v] = vcoActive[v] ? waveforms[v] : IDLE_WAVEFORM;
+		int config = kernelWaveforms[0] | kernelWaveforms[1] << 2 | dividerMode << 4 | (scale ? 1 : 0) << 6;
+		for (int v = 0; v < 2; v++) {
+			config |= inputs[vcoPitchInputs[v]].isConnected() << (7 + 3 * v);
+			config |= inputs[subInputs[v]].isConnected() << (8 + 3 * v);
+			config |= inputs[pwmInputs[v]].isConnected() << (9 + 3 * v);
+		}
+		config |= tables << 13;
+		if (config != kernelConfig) {
+			kernelConfig = config;
+			selectKernels();
+		}
+
+		setMix(sampleTime, totalPatched);
+
+		int oversampleBits = oversample == 8 ? 3 : oversample == 4 ? 2 : oversample == 2 ? 1 : 0;
+		profilePath = (config & 0x3f) | (scale ? quantize : 0) << 6 | oversampleBits << 9 | ((channels - 1) / 4) << 11;
+		for (int v = 0; v < 2; v++)
+			profilePath |= (expFm[v] || linFm[v]) << (13 + v);
+		profilePath |= tables << 15;
+		profilePath |= (sync[0] || sync[1]) << 16;
+		profilePath |= (unisonVoices > 1) << 17;
+
+		for (int v = 0; v < 2; v++)
+			(this->*controlKernels[v])(v, vcoPitchInputs[v], scale);
+
+		for (int v = 0; v < 2; v++) {
+			if (wakeOscs[v])
+				wakeOsc(v);
+		}
+		for (int s = 0; s < SUBS_LEN; s++) {
+			if (wakeSubs[s])
+				wakeSub(s);
+		}
+
+		// a newly patched output starts from a clear decimator, rhythm outputs are written
+		// at the host rate and skip them
+		int count = 0;
+		for (int o = 0; o < OUTPUTS_LEN; o++) {
+			if (!outputs[o].isConnected())
+				continue;
+			if (rhythm && std::find(subOutputs, subOutputs + SUBS_LEN, o) != subOutputs + SUBS_LEN)
+				continue;
+			if (std::find(decimatedOutputs, decimatedOutputs + decimatedCount, o) == decimatedOutputs + decimatedCount) {
+				for (int g = 0; g < 4; g++)
+					decimators[o][g].reset();
+			}
+			decimatedOutputs[count++] = o;
+		}
+		decimatedCount = count;
+
+		// the mix kernel sums its own copies, before it clips
+		foldedCount = 0;
+		for (int i = 0; i < decimatedCount; i++) {
+			if (decimatedOutputs[i] != TOTAL_OUTPUT && decimatedOutputs[i] != TOTAL_RIGHT_OUTPUT)
+				foldedOutputs[foldedCount++] = decimatedOutputs[i];
+		}
+
+		for (int i = 0; i < OUTPUTS_LEN; i++)
+			outputs[i].setChannels(outputChannels);
+
+		tuning.release();
+	}
+
+	// the unison count for the current channels, and the lanes' channels and detune
+	// whenever the count or detune changes
+	void setUnison() {
+		unisonVoices = clamp(unison, 1, std::min((int) UNISON_MAX, 16 / outputChannels));
+		if (unisonVoices == laneVoices && unisonDetune == laneDetune)
+			return;
+		laneVoices = unisonVoices;
+		laneDetune = unisonDetune;
+		unisonGain = 1.f / std::sqrt((float) unisonVoices);
+		for (int l = 0; l < 16; l++) {
+			laneChannels[l] = l / unisonVoices;
+			float span = unisonVoices > 1 ? 2.f * (l % unisonVoices) / (unisonVoices - 1) - 1.f : 0.f;
+			laneSpans[l / 4][l % 4] = span;
+			laneRatios[l / 4][l % 4] = std::exp2(UNISON_DETUNE * unisonDetune * span / 12.f);
+		}
+	}
+
+	// an input's voltages for the four lanes from c. The copies of a channel all read it
+	ALWAYS_INLINE float_4 laneVoltages(int input, int c) {
+		if (unisonVoices == 1)
+			return inputs[input].getPolyVoltageSimd<float_4>(c);
+		Input& in = inputs[input];
+		return float_4(in.getPolyVoltage(laneChannels[c]), in.getPolyVoltage(laneChannels[c + 1]),
+			in.getPolyVoltage(laneChannels[c + 2]), in.getPolyVoltage(laneChannels[c + 3]));
+	}
+
+	// Sums the first copies of each channel's lanes in, times gain, into the channel's
+	// own lane of out. out may be in, as no channel's lanes lie before its own lane
+	ALWAYS_INLINE void foldLanes(const float_4* in, float_4* out, int copies, float gain) {
+		for (int ch = 0; ch < outputChannels; ch++) {
+			int l = ch * unisonVoices;
+			float sum = 0.f;
+			for (int u = 0; u < copies; u++, l++)
+				sum += in[l / 4][l % 4];
+			out[ch / 4][ch % 4] = gain * sum;
+		}
+	}
+
+	// the copies of every patched output but the mix, after a kernel frame
+	void foldUnison() {
+		for (int i = 0; i < foldedCount; i++)
+			foldLanes(frame[foldedOutputs[i]], frame[foldedOutputs[i]], unisonVoices, unisonGain);
+	}
+
+	// the rhythm outputs of every copy are the same, the first is taken
+	void foldRhythm() {
+		for (int s = 0; s < SUBS_LEN; s++)
+			foldLanes(frame[subOutputs[s]], frame[subOutputs[s]], 1, 1.f);
+	}
+
+	// set the kernels from the configuration bits built in processControls()
+	void selectKernels() {
+		audioKernel = getAudioKernel(kernelConfig & 3, (kernelConfig >> 2) & 3, (kernelConfig >> 4) & 3, (kernelConfig >> 13) & 1);
+		for (int v = 0; v < 2; v++) {
+			int bits = kernelConfig >> (7 + 3 * v);
+			controlKernels[v] = getControlKernel((kernelConfig >> 6) & 1, bits & 1, (bits >> 1) & 1, (bits >> 2) & 1);
+		}
+	}
+
+	// dispatch table of the per VCO control kernels
+	static ControlKernel getControlKernel(bool quantize, bool pitchCv, bool subCv, bool pwmCv) {
+#define CONTROL_KERNELS(Q, P) \
+		{{&SubharmonicGenerator::processVcoControls<Q, P, false, false>, &SubharmonicGenerator::processVcoControls<Q, P, false, true>}, \
+		 {&SubharmonicGenerator::processVcoControls<Q, P, true, false>, &SubharmonicGenerator::processVcoControls<Q, P, true, true>}}
+		static const ControlKernel kernels[2][2][2][2] = {
+			{CONTROL_KERNELS(false, false), CONTROL_KERNELS(false, true)},
+			{CONTROL_KERNELS(true, false), CONTROL_KERNELS(true, true)}
+		};
+#undef CONTROL_KERNELS
+		return kernels[quantize][pitchCv][subCv][pwmCv];
+	}
+
+	// dispatch table of the audio kernels
+	static AudioKernel getAudioKernel(int waveform1, int waveform2, int mode, bool tables) {
+#define AUDIO_KERNELS(W1, W2, T) \
+		{&SubharmonicGenerator::processAudio<W1, W2, EDGE_COUNT_MODE, T>, &SubharmonicGenerator::processAudio<W1, W2, PHASE_LOCK_MODE, T>, \
+		 &SubharmonicGenerator::processAudio<W1, W2, RHYTHM_MODE, T>}
+#define WAVEFORM_KERNELS(W1, T) \
+		{AUDIO_KERNELS(W1, 0, T), AUDIO_KERNELS(W1, 1, T), AUDIO_KERNELS(W1, 2, T), AUDIO_KERNELS(W1, 3, T)}
+		static const AudioKernel kernels[2][4][4][DIVIDER_MODES_LEN] = {
+			{WAVEFORM_KERNELS(0, false), WAVEFORM_KERNELS(1, false), WAVEFORM_KERNELS(2, false), WAVEFORM_KERNELS(3, false)},
+			{WAVEFORM_KERNELS(0, true), WAVEFORM_KERNELS(1, true), WAVEFORM_KERNELS(2, true), WAVEFORM_KERNELS(3, true)}
+		};
+#undef WAVEFORM_KERNELS
+#undef AUDIO_KERNELS
+		return kernels[tables][waveform1][waveform2][mode];
+	}
+
+	// control kernel for one VCO, specialised on quantizing and which of its inputs are patched
+	template <bool QUANTIZE, bool PITCH_CV, bool SUB_CV, bool PWM_CV>
+	void processVcoControls(int v, int pitchInput, const ScaleTable* scale) {
+		for (int c = 0; c < channels; c += 4) {
+			int g = c / 4;
+
+			float_4 freq = params[OSC_PARAM + v].getValue();
+			if (PITCH_CV)
+				freq *= dsp::exp2_taylor5(laneVoltages(pitchInput, c));
+
+			// quantize notes based on switch position
+			if (QUANTIZE) {
+				int lanes = std::min(channels - c, 4);
+				for (int i = 0; i < lanes; i++)
+					freq[i] = quantizers[v][c + i].process(scale, freq[i]);
+			}
+			// unison copies are detuned after quantizing, each keeps its own distance from the note
+			freq *= laneRatios[g];
+
+			VcoVoice<SUBS>& voice = voices[g][v];
+			SquareWaveGenerator<float_4>& osc = voice.osc;
+			osc.freq = freq;
+			baseFreqs[v][g] = freq;
+			osc.dutyCycle = 0.5f;
+			if (PWM_CV)
+				osc.dutyCycle = simd::rescale(laneVoltages(pwmInputs[v], c), -5.f, 5.f, 0.01f, 0.99f);
+
+			// set the sub divisions from the knobs or the sub CV
+			for (int i = 0; i < SUBS; i++) {
+				SubVoice& sub = voice.subs[i];
+				float_4 x;
+				if (SUB_CV)
+					x = simd::rescale(laneVoltages(subInputs[v], c), -5.f, 5.f, 0.f, 16.f);
+				else
+					x = params[SUB_PARAM + SUBS * v + i].getValue();
+
+				// only the sub CV is held, the first reading after it is patched is taken as it is
+				float_4 n = simd::floor(x);
+				bool hold = SUB_CV && divisionHysteresis;
+				if (hold && sub.divisionHeld)
+					n = simd::ifelse((x > sub.heldDivision - DIVISION_HYSTERESIS) & (x < sub.heldDivision + 1.f + DIVISION_HYSTERESIS), sub.heldDivision, n);
+				sub.heldDivision = n;
+				sub.divisionHeld = hold;
+
+				sub.divider.setChangeMode(divisionChange);
+				sub.phaseDivider.setChangeMode(divisionChange);
+				sub.divider.setN(n);
+				sub.phaseDivider.setN(n);
+			}
+		}
+	}
+
+	// render one frame of every voice, specialised on both waveforms, the divider mode and
+	// whether the saws come from the wavetables
+	template <int WAVEFORM1, int WAVEFORM2, int DIVIDER_MODE, bool TABLES>
+	void processAudio(float sampleTime) {
+		for (int c = 0; c < channels; c += 4) {
+			int g = c / 4;
+			selectVco<WAVEFORM1, DIVIDER_MODE, TABLES>(0, g, sampleTime);
+			selectVco<WAVEFORM2, DIVIDER_MODE, TABLES>(1, g, sampleTime);
+		}
+	}
+
+	// through-zero FM and sync are picked per VCO here, they only change at control rate
+	template <int WAVEFORM, int DIVIDER_MODE, bool TABLES>
+	ALWAYS_INLINE void selectVco(int v, int g, float sampleTime) {
+		if (sync[v]) {
+			if (linFm[v])
+				processVco<WAVEFORM, DIVIDER_MODE, TABLES, true, true>(v, g, sampleTime);
+			else
+				processVco<WAVEFORM, DIVIDER_MODE, TABLES, false, true>(v, g, sampleTime);
+		}
+		else {
+			if (linFm[v])
+				processVco<WAVEFORM, DIVIDER_MODE, TABLES, true, false>(v, g, sampleTime);
+			else
+				processVco<WAVEFORM, DIVIDER_MODE, TABLES, false, false>(v, g, sampleTime);
+		}
+	}
+
+	// render one VCO and its subs into the frame, the mix kernel sums them.
+	// THROUGH_ZERO follows a frequency that may go negative, SYNC takes up the resets
+	// readSync() has placed
+	template <int WAVEFORM, int DIVIDER_MODE, bool TABLES, bool THROUGH_ZERO, bool SYNC>
+	ALWAYS_INLINE void processVco(int v, int g, float sampleTime) {
+		VcoVoice<SUBS>& voice = voices[g][v];
+		SquareWaveGenerator<float_4>& osc = voice.osc;
+		float_4 oscOut = 0.f;
+		float_4 subOuts[SUBS] = {};
+
+		// nothing heard, the VCO is caught up at control rate instead
+		if (WAVEFORM == IDLE_WAVEFORM) {
+			frame[oscOutputs[v]][g] = oscOut;
+			for (int i = 0; i < SUBS; i++)
+				frame[subOutputs[SUBS * v + i]][g] = subOuts[i];
+			return;
+		}
+
+		osc.template advance<THROUGH_ZERO>(sampleTime);
+
+		// lanes with a reset due in this frame, and where it falls
+		float_4 reset = float_4::zero();
+		float_4 resetP = 0.f;
+		if (SYNC) {
+			voice.syncTime -= 1.f;
+			reset = (voice.syncTime <= 0.f) & (voice.syncTime > -1.f);
+			if (simd::movemask(reset)) {
+				resetP = voice.syncTime;
+				float_4 step = osc.template reset<THROUGH_ZERO>(reset, resetP);
+				if (WAVEFORM != 0 && oscActive[v])
+					insertDiscontinuities(osc.sqrMinBlep, reset, resetP, step);
+			}
+		}
+
+		// the band limited square is only needed when it is heard
+		if (WAVEFORM != 0 && oscActive[v])
+			osc.template bandLimit<THROUGH_ZERO>();
+
+		// the rhythm outputs are left to processRhythm()
+		if (DIVIDER_MODE == RHYTHM_MODE) {
+			if (SYNC && simd::movemask(reset) && WAVEFORM == 0 && oscActive[v])
+				voice.saw.template restart<!TABLES>(reset, 1.f - osc.dutyCycle, resetP, osc.freq * sampleTime);
+			if (oscActive[v])
+				oscOut = WAVEFORM == 0 ? edgeSaw<TABLES, THROUGH_ZERO>(voice.saw, osc.naiveSqr, osc.freq, sampleTime, osc.edgeP) : osc.sqr();
+			oscOut *= oscLevels[v];
+			frame[oscOutputs[v]][g] = oscOut;
+			return;
+		}
+
+		if (DIVIDER_MODE == PHASE_LOCK_MODE)
+			processPhaseLocked<WAVEFORM, TABLES, THROUGH_ZERO, SYNC>(v, voice, sampleTime, reset, resetP, oscOut, subOuts);
+		else
+			processEdgeCounted<WAVEFORM, TABLES, THROUGH_ZERO, SYNC>(v, voice, sampleTime, reset, resetP, oscOut, subOuts);
+
+		oscOut *= oscLevels[v];
+		frame[oscOutputs[v]][g] = oscOut;
+		for (int i = 0; i < SUBS; i++) {
+			subOuts[i] *= subLevels[SUBS * v + i];
+			frame[subOutputs[SUBS * v + i]][g] = subOuts[i];
+		}
+	}
+
+	// subs counted from the edges of the VCO's square, outputs not heard are left at zero.
+	// A reset restarts the dividers after they have counted the frame
+	template <int WAVEFORM, bool TABLES, bool THROUGH_ZERO, bool SYNC>
+	void processEdgeCounted(int v, VcoVoice<SUBS>& voice, float sampleTime, float_4 reset, float_4 resetP, float_4& oscOut, float_4* subOuts) {
+		SquareWaveGenerator<float_4>& osc = voice.osc;
+
+		// the dividers and converters follow the naive square and place
+		// their edges at the oscillator's edge position. The dividers always
+		// count so the subs stay in phase while they are not heard, and count
+		// back down while the oscillator runs backwards
+		float_4 sqr = osc.naiveSqr;
+		voice.sqrGate.set(sqr);
+		float_4 subs[SUBS];
+		for (int i = 0; i < SUBS; i++) {
+			TFrequencyDivider<float_4>& divider = voice.subs[i].divider;
+			subs[i] = simd::ifelse(THROUGH_ZERO ? divider.process(voice.sqrGate, osc.deltaPhase < 0.f) : divider.process(voice.sqrGate), 5.f, -5.f);
+		}
+		if (SYNC && simd::movemask(reset))
+			restartEdgeCounted<WAVEFORM, TABLES, THROUGH_ZERO>(v, voice, sampleTime, reset, resetP, subs);
+
+		// Set outputs based on the waveform switch
+		if (oscActive[v])
+			oscOut = WAVEFORM == 0 ? edgeSaw<TABLES, THROUGH_ZERO>(voice.saw, sqr, osc.freq, sampleTime, osc.edgeP) : osc.sqr();
+
+		for (int i = 0; i < SUBS; i++) {
+			if (!subActive[SUBS * v + i])
+				continue;
+			SubVoice& sub = voice.subs[i];
+			if (WAVEFORM == 2)
+				subOuts[i] = sub.square.process(subs[i], osc.edgeP);
+			else
+				subOuts[i] = edgeSaw<TABLES, THROUGH_ZERO>(sub.saw, subs[i], osc.freq / sub.divider.N, sampleTime, osc.edgeP);
+		}
+	}
+
+	// subs computed from the VCO's phase accumulator, outputs not heard are left at zero
+	template <int WAVEFORM, bool TABLES, bool THROUGH_ZERO, bool SYNC>
+	void processPhaseLocked(int v, VcoVoice<SUBS>& voice, float sampleTime, float_4 reset, float_4 resetP, float_4& oscOut, float_4* subOuts) {
+		SquareWaveGenerator<float_4>& osc = voice.osc;
+		float_4 backward = THROUGH_ZERO ? osc.deltaPhase < 0.f : float_4::zero();
+
+		for (int i = 0; i < SUBS; i++)
+			voice.subs[i].phaseDivider.process<THROUGH_ZERO>(osc.phase, osc.rise, osc.riseP, osc.deltaPhase);
+		if (SYNC && simd::movemask(reset))
+			restartPhaseLocked<WAVEFORM, TABLES>(v, voice, sampleTime, reset, resetP, backward);
+
+		// Set outputs based on the waveform switch
+		if (oscActive[v])
+			oscOut = WAVEFORM == 0 ? phaseSaw<TABLES, THROUGH_ZERO>(voice.saw, osc.phase, osc.rise, osc.riseP, backward, osc.freq, sampleTime) : osc.sqr();
+
+		for (int i = 0; i < SUBS; i++) {
+			if (!subActive[SUBS * v + i])
+				continue;
+			SubVoice& sub = voice.subs[i];
+			PhaseDivider<float_4>& divider = sub.phaseDivider;
+			if (WAVEFORM == 2)
+				subOuts[i] = sub.square.process(divider.sqr(), divider.edgeP());
+			else
+				subOuts[i] = phaseSaw<TABLES, THROUGH_ZERO>(sub.saw, divider.phase, divider.rise, divider.riseP, backward, osc.freq / divider.N, sampleTime);
+		}
+	}
+
+	// Restart the edge counted dividers and the saws heard in the lanes of reset, after
+	// the VCO has. The VCO saw ramps from the square's fall, so it restarts at 1 - duty,
+	// and the sub saws where edgeCountedSawPhase() has them at the start of a sub cycle
+	template <int WAVEFORM, bool TABLES, bool THROUGH_ZERO>
+	void restartEdgeCounted(int v, VcoVoice<SUBS>& voice, float sampleTime, float_4 reset, float_4 resetP, float_4* subs) {
+		SquareWaveGenerator<float_4>& osc = voice.osc;
+		float_4 backward = THROUGH_ZERO ? osc.deltaPhase < 0.f : float_4::zero();
+		if (WAVEFORM == 0 && oscActive[v])
+			voice.saw.template restart<!TABLES>(reset, 1.f - osc.dutyCycle, resetP, osc.freq * sampleTime);
+
+		for (int i = 0; i < SUBS; i++) {
+			SubVoice& sub = voice.subs[i];
+			sub.divider.restart(reset, backward);
+			subs[i] = simd::ifelse(sub.divider.phase, 5.f, -5.f);
+			if (WAVEFORM != 2 && subActive[SUBS * v + i]) {
+				// the sub is high for the first N master edges of its cycle
+				float_4 n = sub.divider.N;
+				float_4 cycles = simd::floor(n * 0.5f);
+				float_4 start = (cycles + (n - 2.f * cycles) * (1.f - osc.dutyCycle)) / n;
+				sub.saw.template restart<!TABLES>(reset, start, resetP, osc.freq / n * sampleTime);
+			}
+		}
+	}
+
+	// Restart the phase locked dividers and the saws heard in the lanes of reset, after
+	// the VCO has. The saws restart with their phase, at the top in backward lanes. The
+	// wavetables read the phase directly, so they have nothing to restart
+	template <int WAVEFORM, bool TABLES>
+	void restartPhaseLocked(int v, VcoVoice<SUBS>& voice, float sampleTime, float_4 reset, float_4 resetP, float_4 backward) {
+		SquareWaveGenerator<float_4>& osc = voice.osc;
+		float_4 start = simd::ifelse(backward, 1.f, 0.f);
+		if (WAVEFORM == 0 && !TABLES && oscActive[v])
+			voice.saw.restart(reset, start, resetP, osc.freq * sampleTime);
+
+		for (int i = 0; i < SUBS; i++) {
+			SubVoice& sub = voice.subs[i];
+			sub.phaseDivider.restart(reset, osc.phase, resetP, backward);
+			if (WAVEFORM != 2 && !TABLES && subActive[SUBS * v + i])
+				sub.saw.restart(reset, start, resetP, osc.freq / sub.phaseDivider.N * sampleTime);
+		}
+	}
+
+	// a saw ramping from each falling edge of sqr, band limited by the converter or
+	// read from the wavetable
+	template <bool TABLES, bool THROUGH_ZERO>
+	ALWAYS_INLINE float_4 edgeSaw(WaveformConverter<float_4>& saw, float_4 sqr, float_4 freq, float sampleTime, float_4 edgeP) {
+		if (TABLES)
+			return readTable(saw.toPhase<THROUGH_ZERO>(sqr, freq, sampleTime, edgeP), freq * sampleTime);
+		return saw.toSaw<THROUGH_ZERO>(sqr, freq, sampleTime, edgeP);
+	}
+
+	// a saw at a phase accumulator's phase, wrap and wrapP mark the accumulator's wraps
+	template <bool TABLES, bool THROUGH_ZERO>
+	ALWAYS_INLINE float_4 phaseSaw(WaveformConverter<float_4>& saw, float_4 phase, float_4 wrap, float_4 wrapP, float_4 backward, float_4 freq, float sampleTime) {
+		if (TABLES)
+			return readTable(phase, freq * sampleTime);
+		return saw.fromPhase<THROUGH_ZERO>(phase, wrap, wrapP, backward);
+	}
+
+	// the wavetable shape, or the morph between two
+	ALWAYS_INLINE float_4 readTable(float_4 phase, float_4 deltaPhase) {
+		float_4 out = readWavetable(*wavetables, tableShape, phase, deltaPhase);
+		if (tableBlend != 0.f)
+			out += tableBlend * (readWavetable(*wavetables, tableShape + 1, phase, deltaPhase) - out);
+		return out;
+	}
+
+	// Set the mix weights and pick the mix kernel, at control rate. Voices are spread
+	// evenly from VCO1 on the left to VCO2's last sub on the right, with a balance law
+	// that leaves a centred voice at full level on both sides. Unison copies spread out
+	// from their voice's place. The rhythm outputs are not mixed
+	void setMix(float sampleTime, bool patched) {
+		const int voiceCount = 2 * (1 + SUBS);
+		for (int v = 0; v < 2; v++) {
+			for (int k = 0; k <= SUBS; k++) {
+				float pan = clamp(stereoSpread, 0.f, 1.f) * (2.f * ((1 + SUBS) * v + k) / (voiceCount - 1) - 1.f);
+				float weight = (k > 0 && rhythm ? 0.f : 1.f) * unisonGain;
+				for (int g = 0; g < (channels + 3) / 4; g++) {
+					float_4 lanePan = simd::clamp(pan + clamp(unisonSpread, 0.f, 1.f) * laneSpans[g], -1.f, 1.f);
+					mixWeights[0][v][k][g] = weight * simd::fmin(1.f, 1.f - lanePan);
+					mixWeights[1][v][k][g] = weight * simd::fmin(1.f, 1.f + lanePan);
+				}
+			}
+		}
+		dcCoefficient = DcBlocker<float_4>::coefficient(DC_BLOCKER_CUTOFF, sampleTime);
+
+		bool stereo = outputs[TOTAL_RIGHT_OUTPUT].isConnected();
+		bool folded = unisonVoices > 1;
+		int config = patched | stereo << 1 | mixDcBlocker << 2 | (mixSaturation == MIX_SOFT_CLIP) << 3 | folded << 4;
+		if (config == mixConfig)
+			return;
+		// the blockers start from silence when they are switched in
+		bool wasBlocking = mixConfig >= 0 && ((mixConfig >> 2) & 1);
+		if (mixDcBlocker && !wasBlocking) {
+			for (int g = 0; g < 4; g++) {
+				dcBlockers[0][g].reset();
+				dcBlockers[1][g].reset();
+			}
+		}
+		mixConfig = config;
+		mixKernel = patched ? getMixKernel(stereo, mixDcBlocker, mixSaturation == MIX_SOFT_CLIP, folded) : nullptr;
+	}
+
+	// dispatch table of the mix kernels
+	static MixKernel getMixKernel(bool stereo, bool dcBlocker, bool softClip, bool folded) {
+#define MIX_KERNELS(S, F) \
+		{{&SubharmonicGenerator::processMix<S, false, false, F>, &SubharmonicGenerator::processMix<S, false, true, F>}, \
+		 {&SubharmonicGenerator::processMix<S, true, false, F>, &SubharmonicGenerator::processMix<S, true, true, F>}}
+		static const MixKernel kernels[2][2][2][2] = {
+			{MIX_KERNELS(false, false), MIX_KERNELS(false, true)},
+			{MIX_KERNELS(true, false), MIX_KERNELS(true, true)}
+		};
+#undef MIX_KERNELS
+		return kernels[stereo][folded][dcBlocker][softClip];
+	}
+
+	// mix one frame of the voices into TOTAL, and TOTAL_RIGHT when it is patched.
+	// Runs after the audio kernel at its rate, so the clipping is oversampled with it.
+	// FOLDED sums each channel's unison copies before the DC blocker and clipper
+	template <bool STEREO, bool DC_BLOCKER, bool SOFT_CLIP, bool FOLDED>
+	void processMix() {
+		if (FOLDED) {
+			float_4 sides[2][4];
+			for (int g = 0; g < (channels + 3) / 4; g++) {
+				sides[0][g] = mixSide(0, g);
+				if (STEREO)
+					sides[1][g] = mixSide(1, g);
+			}
+			foldLanes(sides[0], frame[TOTAL_OUTPUT], unisonVoices, 1.f);
+			if (STEREO)
+				foldLanes(sides[1], frame[TOTAL_RIGHT_OUTPUT], unisonVoices, 1.f);
+
+			for (int c = 0; c < outputChannels; c += 4) {
+				int g = c / 4;
+				frame[TOTAL_OUTPUT][g] = finishMix<DC_BLOCKER, SOFT_CLIP>(frame[TOTAL_OUTPUT][g], dcBlockers[0][g]);
+				if (STEREO)
+					frame[TOTAL_RIGHT_OUTPUT][g] = finishMix<DC_BLOCKER, SOFT_CLIP>(frame[TOTAL_RIGHT_OUTPUT][g], dcBlockers[1][g]);
+			}
+			return;
+		}
+
+		for (int c = 0; c < channels; c += 4) {
+			int g = c / 4;
+			frame[TOTAL_OUTPUT][g] = finishMix<DC_BLOCKER, SOFT_CLIP>(mixSide(0, g), dcBlockers[0][g]);
+			if (STEREO)
+				frame[TOTAL_RIGHT_OUTPUT][g] = finishMix<DC_BLOCKER, SOFT_CLIP>(mixSide(1, g), dcBlockers[1][g]);
+		}
+	}
+
+	// one side of the mix, summed VCO by VCO straight from the frame
+	ALWAYS_INLINE float_4 mixSide(int side, int g) {
+		float_4 out = 0.f;
+		for (int v = 0; v < 2; v++) {
+			const float_4 (*weights)[4] = mixWeights[side][v];
+			float_4 vco = frame[oscOutputs[v]][g] * weights[0][g];
+			for (int i = 0; i < SUBS; i++)
+				vco += frame[subOutputs[SUBS * v + i]][g] * weights[1 + i][g];
+			out += vco;
+		}
+		return out;
+	}
+
+	template <bool DC_BLOCKER, bool SOFT_CLIP>
+	ALWAYS_INLINE float_4 finishMix(float_4 out, DcBlocker<float_4>& dcBlocker) {
+		if (DC_BLOCKER)
+			out = dcBlocker.process(out, dcCoefficient);
+		return SOFT_CLIP ? softClip(out) : simd::clamp(out, -MIX_LIMIT, MIX_LIMIT);
+	}
+
+	// Rhythm mode, once per host sample. The dividers count the clock's rising edges on
+	// the sample they happen and open a gate or trigger there, the outputs are not
+	// decimated so nothing is added to that. No audio rate work is done for the subs
+	void processRhythm(float sampleTime) {
+		for (int c = 0; c < channels; c += 4) {
+			int g = c / 4;
+			TGateProcessor<float_4>& clk = clockGates[g];
+			clk.set(laneVoltages(CLOCK_INPUT, c));
+			for (int s = 0; s < SUBS_LEN; s++) {
+				SubVoice& sub = voices[g][s / SUBS].subs[s % SUBS];
+				float_4 beat = sub.divider.processBeats(clk);
+				float_4 on;
+				if (rhythmOutput == RHYTHM_TRIGGERS) {
+					sub.triggerTime = simd::ifelse(beat, TRIGGER_TIME, sub.triggerTime - sampleTime);
+					on = sub.triggerTime > 0.f;
+				}
+				else {
+					on = clk.high() & (sub.divider.count == 0.f);
+				}
+				frame[subOutputs[s]][g] = simd::ifelse(on, 10.f, 0.f);
+			}
+		}
+	}
+
+	// Audio rate FM on top of the control rate pitch, once per host sample: exponential
+	// at 1 V/oct, and linear through-zero, swinging the frequency by its own size per
+	// 5 V. Both work on four channels at a time
+	void applyFm(int v) {
+		for (int c = 0; c < channels; c += 4) {
+			float_4 freq = baseFreqs[v][c / 4];
+			if (expFm[v])
+				freq *= dsp::exp2_taylor5(laneVoltages(EXP_FM_INPUT + v, c));
+			if (linFm[v])
+				freq *= 1.f + 0.2f * laneVoltages(LIN_FM_INPUT + v, c);
+			voices[c / 4][v].osc.freq = freq;
+		}
+	}
+
+	// Read a VCO's sync input, once per host sample. A rise through the gate's upper
+	// threshold resets the VCO where the input crossed it, found by linear interpolation
+	// between the last two samples and counted in kernel frames from the host sample's
+	// start. An idle VCO only keeps the age of its latest reset for skipVco()
+	void readSync(int v, int factor) {
+		const float threshold = 2.f;
+		for (int c = 0; c < channels; c += 4) {
+			VcoVoice<SUBS>& voice = voices[c / 4][v];
+			float_4 x = laneVoltages(SYNC_INPUT + v, c);
+			float_4 last = voice.lastSync;
+			voice.lastSync = x;
+			voice.syncGate.set(x);
+			float_4 rise = voice.syncGate.leadingEdge();
+
+			// most samples have no reset
+			float_4 t = 1.f;
+			if (simd::movemask(rise))
+				t = simd::clamp(simd::ifelse(rise, (threshold - last) / (x - last), 1.f), 0.f, 1.f);
+
+			if (vcoActive[v])
+				voice.syncTime = simd::ifelse(rise, simd::fmax(t * factor, 1e-6f), -2.f);
+			else
+				voice.syncAge = simd::ifelse(rise, (1.f - t) * factor, simd::ifelse(voice.syncAge >= 0.f, voice.syncAge + factor, -1.f));
+		}
+	}
+
+	// Move an idle VCO and its dividers on by a number of kernel frames in one step.
+	// Lanes reset while it was idle restart there and move on from the reset
+	void skipVco(int v, float sampleTime, int frames) {
+		for (int g = 0; g < (channels + 3) / 4; g++) {
+			VcoVoice<SUBS>& voice = voices[g][v];
+			float_4 span = (float) frames;
+			float_4 reset = voice.syncAge >= 0.f;
+			if (simd::movemask(reset)) {
+				voice.osc.phase = simd::ifelse(reset, 0.f, voice.osc.phase);
+				for (SubVoice& sub : voice.subs) {
+					if (!rhythm)
+						sub.divider.restart(reset);
+					sub.phaseDivider.restart(reset, 0.f, 0.f);
+				}
+				span = simd::ifelse(reset, simd::fmin(voice.syncAge, span), span);
+				voice.syncAge = -1.f;
+			}
+
+			float_4 rises, falls;
+			voice.osc.skip(sampleTime, span, rises, falls);
+
+			if (!rhythm)
+				voice.sqrGate.sync(voice.osc.naiveSqr);
+			for (SubVoice& sub : voice.subs) {
+				if (!rhythm)
+					sub.divider.skip(rises + falls, voice.osc.naiveSqr);
+				sub.phaseDivider.skip(rises, voice.osc.phase);
+			}
+		}
+	}
+
+	// restart a VCO's band limiting and saw ramp from where its phase is now
+	void wakeOsc(int v) {
+		for (int g = 0; g < (channels + 3) / 4; g++) {
+			SquareWaveGenerator<float_4>& osc = voices[g][v].osc;
+			clearMinBlep(osc.sqrMinBlep);
+			osc.sqrValue = osc.naiveSqr;
+
+			// the edge counted saw ramps from the square's falling edge
+			float_4 sawPhase = osc.phase - osc.dutyCycle;
+			sawPhase += simd::ifelse(sawPhase < 0.f, 1.f, 0.f);
+			voices[g][v].saw.resync(osc.naiveSqr, dividerMode == PHASE_LOCK_MODE ? osc.phase : sawPhase);
+		}
+	}
+
+	// restart a sub's band limiting and saw ramp from where its divider is now
+	void wakeSub(int s) {
+		for (int g = 0; g < (channels + 3) / 4; g++) {
+			VcoVoice<SUBS>& voice = voices[g][s / SUBS];
+			SubVoice& sub = voice.subs[s % SUBS];
+			float_4 sqr;
+			float_4 sawPhase;
+			if (dividerMode == PHASE_LOCK_MODE) {
+				sqr = sub.phaseDivider.sqr();
+				sawPhase = sub.phaseDivider.phase;
+			}
+			else {
+				sqr = simd::ifelse(sub.divider.phase, 5.f, -5.f);
+				sawPhase = edgeCountedSawPhase(voice.osc, sub.divider);
+			}
+			sub.square.resync(sqr);
+			sub.saw.resync(sqr, sawPhase);
+		}
+	}
+
+	// Phase of an edge counted sub saw, in sub cycles since the sub square last fell.
+	// Counted back through the master edges since then, taking them as evenly spaced
+	// at the current duty cycle
+	static float_4 edgeCountedSawPhase(const SquareWaveGenerator<float_4>& osc, const TFrequencyDivider<float_4>& divider) {
+		// master time since its latest edge, a rise while it is high
+		float_4 high = osc.phase < osc.dutyCycle;
+		float_4 sinceEdge = simd::ifelse(high, osc.phase, osc.phase - osc.dutyCycle);
+
+		// master edges between the sub's fall and the latest edge, the sub is high for N of them
+		float_4 edges = simd::fmax(divider.count, 0.f) + simd::ifelse(divider.phase, divider.N, 0.f);
+		float_4 cycles = simd::floor(edges * 0.5f);
+		float_4 odd = edges - 2.f * cycles;
+
+		float_4 t = sinceEdge + cycles + odd * simd::ifelse(high, 1.f - osc.dutyCycle, osc.dutyCycle);
+		float_4 phase = t / divider.N;
+		return phase - simd::floor(phase);
+	}
+
+	void process(const ProcessArgs& args) override {
+		rtguard::Scope guard;
+
+		// two counter reads and a few adds per call, only while the profiler is on
+		if (profiler.enabled.load(std::memory_order_relaxed)) {
+			uint64_t start = instrument::ticks();
+			processFrame(args);
+			profiler.add(profilePath, instrument::ticks() - start);
+		}
+		else {
+			processFrame(args);
+		}
+
+		// nothing more while the panel scope is off or off screen
+		if (scope.enabled.load(std::memory_order_relaxed))
+			tapScope();
+	}
+
+	// one host sample of the whole module
+	void processFrame(const ProcessArgs& args) {
+		int factor = oversample;
+		if (controlsDirty || controlDivider.process()) {
+			controlsDirty = false;
+			processControls(args.sampleTime / factor);
+		}
+		elapsedFrames += factor;
+
+		if (!levelsSettled)
+			levelsSettled = smoothGains(oscLevels, oscLevelTargets, 2, levelCoefficient) & smoothGains(subLevels, subLevelTargets, SUBS_LEN, levelCoefficient);
+
+		for (int v = 0; v < 2; v++) {
+			if (vcoActive[v] && (expFm[v] || linFm[v]))
+				applyFm(v);
+			if (sync[v])
+				readSync(v, factor);
+		}
+
+		// in unison the outputs are summed down to their channels after each frame
+		bool folded = unisonVoices > 1;
+		if (factor == 1) {
+			(this->*audioKernel)(args.sampleTime);
+			if (mixKernel)
+				(this->*mixKernel)();
+			if (folded)
+				foldUnison();
+			if (rhythm) {
+				processRhythm(args.sampleTime);
+				if (folded)
+					foldRhythm();
+			}
+
+			for (int c = 0; c < outputChannels; c += 4) {
+				for (int o = 0; o < OUTPUTS_LEN; o++)
+					outputs[o].setVoltageSimd(frame[o][c / 4], c);
+			}
+			if (busReader)
+				publishVoices(args.frame);
+			// so oversampling again clears the decimators of the samples from before
+			decimatorFactor = 1;
+			return;
+		}
+
+		if (factor != decimatorFactor) {
+			decimatorFactor = factor;
+			for (int o = 0; o < OUTPUTS_LEN; o++) {
+				for (int g = 0; g < 4; g++)
+					decimators[o][g].setFactor(factor);
+			}
+		}
+
+		float sampleTime = args.sampleTime / factor;
+		for (int i = 0; i < factor; i++) {
+			(this->*audioKernel)(sampleTime);
+			if (mixKernel)
+				(this->*mixKernel)();
+			if (folded)
+				foldUnison();
+
+			for (int g = 0; g < (outputChannels + 3) / 4; g++) {
+				for (int i = 0; i < decimatedCount; i++)
+					decimators[decimatedOutputs[i]][g].push(frame[decimatedOutputs[i]][g]);
+			}
+		}
+
+		for (int c = 0; c < outputChannels; c += 4) {
+			for (int i = 0; i < decimatedCount; i++)
+				outputs[decimatedOutputs[i]].setVoltageSimd(decimators[decimatedOutputs[i]][c / 4].process(), c);
+		}
+
+		if (rhythm) {
+			processRhythm(args.sampleTime);
+			if (folded)
+				foldRhythm();
+			for (int c = 0; c < outputChannels; c += 4) {
+				for (int s = 0; s < SUBS_LEN; s++)
+					outputs[subOutputs[s]].setVoltageSimd(frame[subOutputs[s]][c / 4], c);
+			}
+		}
+
+		if (busReader)
+			publishVoices(args.frame);
+	}
+
+	// the first channel of an output this sample, from the port once written, which is
+	// the decimated and folded value, or else from the last frame computed, as only
+	// patched outputs are written while oversampling
+	float scopeVoltage(int o) {
+		if (outputs[o].isConnected())
+			return outputs[o].getVoltage();
+		return frame[o][0][0];
+	}
+
+	// hand the first channel of the shown VCO, its subs and TOTAL to the panel scope
+	void tapScope() {
+		if (!scope.due())
+			return;
+		int v = scope.vco.load(std::memory_order_relaxed);
+		ScopeFrame scopeFrame;
+		scopeFrame.values[SCOPE_VCO] = scopeVoltage(oscOutputs[v]);
+		scopeFrame.values[SCOPE_SUB1] = scopeVoltage(subOutputs[SUBS * v]);
+		scopeFrame.values[SCOPE_SUB2] = scopeVoltage(subOutputs[SUBS * v + 1]);
+		scopeFrame.values[SCOPE_TOTAL] = scopeVoltage(TOTAL_OUTPUT);
+		scope.ring.push(scopeFrame);
+	}
+
+	// write the voice state after this sample to the bus and have Rack hand it over
+	void publishVoices(int64_t hostFrame) {
+		VoiceBusMessage* message = (VoiceBusMessage*) rightExpander.producerMessage;
+		message->frame = hostFrame;
+		message->channels = channels;
+		message->dividerMode = dividerMode;
+		int heard = 0;
+		for (int v = 0; v < 2; v++)
+			heard |= oscActive[v] << v;
+		for (int s = 0; s < SUBS_LEN; s++)
+			heard |= subActive[s] << (2 + s);
+		message->heard = heard;
+
+		for (int c = 0; c < channels; c += 4) {
+			for (int v = 0; v < 2; v++) {
+				VcoVoice<SUBS>& voice = voices[c / 4][v];
+				voice.osc.freq.store(&message->oscFreq[v][c]);
+				voice.osc.phase.store(&message->oscPhase[v][c]);
+				voice.saw.getPhase().store(&message->sawPhase[v][c]);
+
+				for (int i = 0; i < SUBS; i++) {
+					SubVoice& sub = voice.subs[i];
+					int s = SUBS * v + i;
+					float_4 n, count, phase;
+					if (dividerMode == PHASE_LOCK_MODE) {
+						n = sub.phaseDivider.N;
+						count = sub.phaseDivider.cycle;
+						phase = sub.phaseDivider.phase;
+					}
+					else {
+						n = sub.divider.N;
+						count = sub.divider.count;
+						phase = rhythm ? count / n : edgeCountedSawPhase(voice.osc, sub.divider);
+					}
+					n.store(&message->subN[s][c]);
+					count.store(&message->subCount[s][c]);
+					phase.store(&message->subPhase[s][c]);
+					sub.saw.getPhase().store(&message->subSawPhase[s][c]);
+				}
+			}
+		}
+		rightExpander.messageFlipRequested = true;
+	}
+
+	// a profiler path as text, such as "saw/idle, edge counted, 12ET, 4x, up to 8 ch"
+	static std::string describeProfilePath(uint32_t path) {
+		static const char* waveformNames[] = {"saw", "sqr<-saw", "sqr", "idle"};
+		static const char* modeNames[] = {"edge counted", "phase locked", "rhythm", "?"};
+		static const char* quantizeNames[] = {"unquantized", "12ET", "8ET", "12JI", "8JI", "Scala"};
+		std::string text = waveformNames[path & 3];
+		text += "/";
+		text += waveformNames[(path >> 2) & 3];
+		text += ", ";
+		text += modeNames[(path >> 4) & 3];
+		text += ", ";
+		text += quantizeNames[std::min((path >> 6) & 7, 5u)];
+		text += ", " + std::to_string(1 << ((path >> 9) & 3)) + "x";
+		text += ", up to " + std::to_string(4 * (((path >> 11) & 3) + 1)) + " ch";
+		if ((path >> 13) & 3)
+			text += ", FM";
+		if ((path >> 15) & 1)
+			text += ", wavetable";
+		if ((path >> 16) & 1)
+			text += ", sync";
+		if ((path >> 17) & 1)
+			text += ", unison";
+		return text;
+	}
+
+	// 1, 2, 4 or 8, picked up by the audio thread on its next sample
+	void setOversample(int factor) {
+		oversample = factor;
+	}
+
+	void setControlRate(int rate) {
+		controlRate = rate;
+		controlDivider.setDivision(rate);
+		controlDivider.reset();
+		controlsDirty = true;
+	}
+
+	// parse a Scala scale and optional keyboard mapping, build the table and hand it to
+	// the audio thread. Not for the audio thread. returns false with error set on failure
+	bool setTuning(const std::string& scl, const std::string& kbm, std::string& error) {
+		ScalaScale scale;
+		if (!parseScalaScale(scl, scale, error))
+			return false;
+
+		ScalaMapping mapping;
+		if (!kbm.empty() && !parseScalaMapping(kbm, mapping, error))
+			return false;
+
+		std::unique_ptr<ScaleTable> table(new ScaleTable);
+		if (!buildScalaTable(*table, scale, kbm.empty() ? nullptr : &mapping, error))
+			return false;
+
+		tuning.publish(table.release());
+		scalaText = scl;
+		mappingText = kbm;
+		return true;
+	}
+
+	// back to the built in tunings
+	void clearTuning() {
+		tuning.publish(nullptr);
+		scalaText.clear();
+		scalaName.clear();
+		mappingText.clear();
+		mappingName.clear();
+	}
+
+	void onReset(const ResetEvent& e) override {
+		Module::onReset(e);
+		clearTuning();
+		controlsDirty = true;
+	}
+
+	json_t* dataToJson() override {
+		json_t* rootJ = json_object();
+		json_object_set_new(rootJ, "controlRate", json_integer(controlRate));
+		json_object_set_new(rootJ, "dividerMode", json_integer(dividerMode));
+		json_object_set_new(rootJ, "oversample", json_integer(oversample));
+		json_object_set_new(rootJ, "divisionChange", json_integer(divisionChange));
+		json_object_set_new(rootJ, "divisionHysteresis", json_boolean(divisionHysteresis));
+		json_object_set_new(rootJ, "rhythmOutput", json_integer(rhythmOutput));
+		json_object_set_new(rootJ, "wavetable", json_integer(wavetable));
+		json_object_set_new(rootJ, "wavetableMorph", json_real(wavetableMorph));
+		json_object_set_new(rootJ, "mixSaturation", json_integer(mixSaturation));
+		json_object_set_new(rootJ, "mixDcBlocker", json_boolean(mixDcBlocker));
+		json_object_set_new(rootJ, "stereoSpread", json_real(stereoSpread));
+		json_object_set_new(rootJ, "unison", json_integer(unison));
+		json_object_set_new(rootJ, "unisonDetune", json_real(unisonDetune));
+		json_object_set_new(rootJ, "unisonSpread", json_real(unisonSpread));
+		json_object_set_new(rootJ, "scopeDisplay", json_boolean(scopeDisplay));
+		json_object_set_new(rootJ, "scopeVco", json_integer(scopeVco));
+		json_object_set_new(rootJ, "scopeView", json_integer(scopeView));
+		json_object_set_new(rootJ, "scopeTrigger", json_integer(scopeTrigger));
+		json_object_set_new(rootJ, "scopeTimeBase", json_integer(scopeTimeBase));
+
+		if (!scalaText.empty()) {
+			json_object_set_new(rootJ, "scala", json_string(scalaText.c_str()));
+			json_object_set_new(rootJ, "scalaName", json_string(scalaName.c_str()));
+			if (!mappingText.empty()) {
+				json_object_set_new(rootJ, "keyboardMapping", json_string(mappingText.c_str()));
+				json_object_set_new(rootJ, "keyboardMappingName", json_string(mappingName.c_str()));
+			}
+		}
+		return rootJ;
+	}
+
+	void dataFromJson(json_t* rootJ) override {
+		// patches from before the control rate setting read controls every sample, and only
+		// the rates in the menu are taken
+		json_t* controlRateJ = json_object_get(rootJ, "controlRate");
+		int rate = controlRateJ ? (int) json_integer_value(controlRateJ) : 1;
+		setControlRate(rate == 16 || rate == 32 || rate == 64 ? rate : 1);
+
+		json_t* dividerModeJ = json_object_get(rootJ, "dividerMode");
+		if (dividerModeJ)
+			dividerMode = clamp((int) json_integer_value(dividerModeJ), 0, DIVIDER_MODES_LEN - 1);
+
+		json_t* divisionChangeJ = json_object_get(rootJ, "divisionChange");
+		if (divisionChangeJ)
+			divisionChange = clamp((int) json_integer_value(divisionChangeJ), 0, DIVISION_CHANGES_LEN - 1);
+
+		json_t* divisionHysteresisJ = json_object_get(rootJ, "divisionHysteresis");
+		if (divisionHysteresisJ)
+			divisionHysteresis = json_boolean_value(divisionHysteresisJ);
+
+		json_t* rhythmOutputJ = json_object_get(rootJ, "rhythmOutput");
+		if (rhythmOutputJ)
+			rhythmOutput = clamp((int) json_integer_value(rhythmOutputJ), 0, RHYTHM_OUTPUTS_LEN - 1);
+
+		json_t* wavetableJ = json_object_get(rootJ, "wavetable");
+		if (wavetableJ)
+			wavetable = clamp((int) json_integer_value(wavetableJ), 0, WAVETABLES_LEN - 1);
+
+		json_t* wavetableMorphJ = json_object_get(rootJ, "wavetableMorph");
+		if (wavetableMorphJ)
+			wavetableMorph = clamp((float) json_number_value(wavetableMorphJ), 0.f, 1.f);
+
+		json_t* mixSaturationJ = json_object_get(rootJ, "mixSaturation");
+		if (mixSaturationJ)
+			mixSaturation = clamp((int) json_integer_value(mixSaturationJ), 0, MIX_SATURATIONS_LEN - 1);
+
+		json_t* mixDcBlockerJ = json_object_get(rootJ, "mixDcBlocker");
+		if (mixDcBlockerJ)
+			mixDcBlocker = json_boolean_value(mixDcBlockerJ);
+
+		json_t* stereoSpreadJ = json_object_get(rootJ, "stereoSpread");
+		if (stereoSpreadJ)
+			stereoSpread = clamp((float) json_number_value(stereoSpreadJ), 0.f, 1.f);
+
+		json_t* unisonJ = json_object_get(rootJ, "unison");
+		if (unisonJ)
+			unison = clamp((int) json_integer_value(unisonJ), 1, (int) UNISON_MAX);
+
+		json_t* unisonDetuneJ = json_object_get(rootJ, "unisonDetune");
+		if (unisonDetuneJ)
+			unisonDetune = clamp((float) json_number_value(unisonDetuneJ), 0.f, 1.f);
+
+		json_t* unisonSpreadJ = json_object_get(rootJ, "unisonSpread");
+		if (unisonSpreadJ)
+			unisonSpread = clamp((float) json_number_value(unisonSpreadJ), 0.f, 1.f);
+
+		json_t* scopeDisplayJ = json_object_get(rootJ, "scopeDisplay");
+		if (scopeDisplayJ)
+			scopeDisplay = json_boolean_value(scopeDisplayJ);
+
+		json_t* scopeVcoJ = json_object_get(rootJ, "scopeVco");
+		if (scopeVcoJ)
+			scopeVco = clamp((int) json_integer_value(scopeVcoJ), 0, 1);
+
+		json_t* scopeViewJ = json_object_get(rootJ, "scopeView");
+		if (scopeViewJ)
+			scopeView = clamp((int) json_integer_value(scopeViewJ), 0, SCOPE_VIEWS_LEN - 1);
+
+		json_t* scopeTriggerJ = json_object_get(rootJ, "scopeTrigger");
+		if (scopeTriggerJ)
+			scopeTrigger = clamp((int) json_integer_value(scopeTriggerJ), 0, (int) SCOPE_FREE_RUN);
+
+		json_t* scopeTimeBaseJ = json_object_get(rootJ, "scopeTimeBase");
+		if (scopeTimeBaseJ)
+			scopeTimeBase = clamp((int) json_integer_value(scopeTimeBaseJ), 0, SCOPE_TIME_BASES_LEN - 1);
+
+		json_t* oversampleJ = json_object_get(rootJ, "oversample");
+		if (oversampleJ) {
+			int factor = (int) json_integer_value(oversampleJ);
+			setOversample(factor == 2 || factor == 4 || factor == 8 ? factor : 1);
+		}
+
+		// the tuning is stored as the files' text, so the patch does not depend on them
+		clearTuning();
+		const char* scl = json_string_value(json_object_get(rootJ, "scala"));
+		if (scl) {
+			const char* kbm = json_string_value(json_object_get(rootJ, "keyboardMapping"));
+			std::string error;
+			if (!setTuning(scl, kbm ? kbm : "", error)) {
+				WARN("Could not restore the Scala tuning: %s", error.c_str());
+				return;
+			}
+
+			const char* name = json_string_value(json_object_get(rootJ, "scalaName"));
+			scalaName = name ? name : "";
+			name = json_string_value(json_object_get(rootJ, "keyboardMappingName"));
+			mappingName = kbm && name ? name : "";
+		}
+	}
+};
@@ -5,11 +5,11 @@ using namespace rack;
 struct PushButton5 : SvgSwitch {
     PushButton5() {
         // Load SVG files for each state
-        addFrame(APP->window->loadSvg(asset::plugin(pluginInstance, "res/Components/PushButton5_1.svg")));
-        addFrame(APP->window->loadSvg(asset::plugin(pluginInstance, "res/Components/PushButton5_2.svg")));
-        addFrame(APP->window->loadSvg(asset::plugin(pluginInstance, "res/Components/PushButton5_3.svg")));
-        addFrame(APP->window->loadSvg(asset::plugin(pluginInstance, "res/Components/PushButton5_4.svg")));
-        addFrame(APP->window->loadSvg(asset::plugin(pluginInstance, "res/Components/PushButton5_5.svg")));
+        addFrame(Svg::load(asset::plugin(pluginInstance, "res/components/PushButton5_1.svg")));
+        addFrame(Svg::load(asset::plugin(pluginInstance, "res/components/PushButton5_2.svg")));
+        addFrame(Svg::load(asset::plugin(pluginInstance, "res/components/PushButton5_3.svg")));
+        addFrame(Svg::load(asset::plugin(pluginInstance, "res/components/PushButton5_4.svg")));
+        addFrame(Svg::load(asset::plugin(pluginInstance, "res/components/PushButton5_5.svg")));
 
         shadow->opacity = 0.0f;
     }
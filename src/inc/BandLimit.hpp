@@ -0,0 +1,97 @@
+//----------------------------------------------------------------------------
+//	RootNode Plugin for VCV Rack - Band limiting helpers
+//	Places minBLEP corrections at sub sample positions, one voice per lane
+//	of a simd vector type such as simd::float_4
+//----------------------------------------------------------------------------
+#pragma once
+#include "Utility.hpp"
+
+// The minBLEP impulse shared by every MinBlepBuffer, built on first use. Z zero
+// crossings at O times oversampling, with a trailing 1 for the interpolation
+template <int Z, int O>
+const float* minBlepTable() {
+	struct Table {
+		float impulse[2 * Z * O + 1];
+		Table() {
+			dsp::minBlepImpulse(Z, O, impulse);
+			impulse[2 * Z * O] = 1.f;
+		}
+	};
+	static const Table table;
+	return table.impulse;
+}
+
+// Same corrections as dsp::MinBlepGenerator, without the generator's own copy of
+// the impulse table, a couple of kB per instance. Only the ring of pending
+// corrections is kept per voice
+template <int Z, int O, typename T>
+struct MinBlepBuffer {
+	T buf[2 * Z] = {};
+	int pos = 0;
+	const float* impulse = minBlepTable<Z, O>();
+
+	// a discontinuity of size x at p in (-1, 0] relative to the current frame
+	void insertDiscontinuity(float p, T x) {
+		if (!(-1 < p && p <= 0))
+			return;
+		for (int j = 0; j < 2 * Z; j++) {
+			float minBlepIndex = ((float) j - p) * O;
+			int index = (int) minBlepIndex;
+			float indexFrac = minBlepIndex - index;
+			float minBlepFrac = impulse[index] + (impulse[index + 1] - impulse[index]) * indexFrac;
+			buf[(pos + j) % (2 * Z)] += x * (-1.f + minBlepFrac);
+		}
+	}
+
+	T process() {
+		T v = buf[pos];
+		buf[pos] = 0.f;
+		pos = (pos + 1) % (2 * Z);
+		return v;
+	}
+};
+
+// the minBLEP used by every band limited waveform here
+template <typename T>
+using MinBlep = MinBlepBuffer<16, 16, T>;
+
+// insert a discontinuity of size x into every lane set in mask, p is the lane's
+// position relative to the current frame in (-1, 0]
+template <typename T>
+ALWAYS_INLINE void insertDiscontinuities(MinBlep<T>& minBlep, T mask, T p, T x) {
+	int bits = simd::movemask(mask);
+	if (!bits)
+		return;
+
+	for (int i = 0; i < T::size; i++) {
+		if (bits & (1 << i))
+			minBlep.insertDiscontinuity(p[i], simd::movemaskInverse<T>(1 << i) & x);
+	}
+}
+
+// drop the corrections still pending in a minBLEP generator
+template <typename T>
+void clearMinBlep(MinBlep<T>& minBlep) {
+	for (int i = 0; i < 2 * 16; i++)
+		minBlep.buf[i] = 0.f;
+}
+
+// band limits a naive square wave given the position of its edges
+template <typename T>
+struct BandLimitedSquare {
+	MinBlep<T> minBlep;
+	T last = 0.f;
+
+	T process(T naive, T edgeP) {
+		insertDiscontinuities(minBlep, naive != last, edgeP, naive - last);
+		last = naive;
+
+		return naive + minBlep.process();
+	}
+
+	// restart from the given naive value without an edge
+	void resync(T naive) {
+		last = naive;
+		clearMinBlep(minBlep);
+	}
+};
@@ -4,6 +4,7 @@
 //----------------------------------------------------------------------------
 #pragma once
 #include "GateProcessor.hpp"
+#include "Utility.hpp"
 
 #define COUNT_UP 1
 #define COUNT_DN 2
@@ -74,4 +75,201 @@ struct FrequencyDivider {
 		phase = false;
 		gate.reset();
 	}
-};
\ No newline at end of file
+};
+
+//----------------------------------------------------------------------------
+//	RootNode Plugin for VCV Rack - SIMD frequency divider
+//	Lane-wise port of FrequencyDivider for simd vector types such as
+//	simd::float_4. Counts are held as floats, the phase as a lane mask.
+//	A new division from setN() waits in nextN until the boundary named by
+//	the change mode, then the count is carried over in proportion.
+//----------------------------------------------------------------------------
+template <typename T>
+struct TFrequencyDivider {
+	T count = 0.f;
+	T N = 0.f;
+	T nextN = 0.f;
+	float maxN = 20.f;
+	int countMode = COUNT_DN;
+	int changeMode = CHANGE_AT_SUB_CYCLE;
+
+	T phase = 0.f;
+	TGateProcessor<T> gate;
+
+	// process the given clock values and return the current divider states as a lane mask
+	ALWAYS_INLINE T process(T clk) {
+		gate.set(clk);
+		return process(gate);
+	}
+
+	// as process(), following a clock gate the caller has already set. Dividers on the
+	// same clock can share one gate this way instead of each running their own
+	ALWAYS_INLINE T process(const TGateProcessor<T>& clk) {
+		T edge = clk.anyEdge();
+
+		// a new division waiting for the master's next cycle starts on its rise
+		if (changeMode == CHANGE_AT_MASTER_CYCLE)
+			takeNextN(edge & clk.high());
+
+		count = simd::ifelse(edge, count + 1.f, count);
+
+		// for count up mode, flip the phase and reset the count at the end of the count
+		T flip = 0.f;
+		if (countMode == COUNT_UP)
+			flip = edge & (count == N);
+
+		// we've hit the counter
+		count = simd::ifelse(edge & (count >= N), 0.f, count);
+
+		// for count down mode, flip the phase and reset the count at the start
+		if (countMode == COUNT_DN)
+			flip = edge & (count == 0.f);
+		phase = phase ^ flip;
+
+		// or for the sub's next cycle, which starts from a count of 0 as the phase goes high
+		if (changeMode == CHANGE_AT_SUB_CYCLE)
+			N = simd::ifelse(flip & phase, nextN, N);
+
+		return phase;
+	}
+
+	// as process(), except an edge in a reverse lane undoes a step of the count, so
+	// the divider retraces its states when its clock runs backwards
+	ALWAYS_INLINE T process(T clk, T reverse) {
+		gate.set(clk);
+		return process(gate, reverse);
+	}
+
+	ALWAYS_INLINE T process(const TGateProcessor<T>& clk, T reverse) {
+		T edge = clk.anyEdge();
+		T back = edge & reverse;
+		edge = edge & ~reverse;
+
+		// backwards, a master cycle starts as the clock falls
+		if (changeMode == CHANGE_AT_MASTER_CYCLE)
+			takeNextN((edge & clk.high()) | (back & clk.low()));
+
+		count = simd::ifelse(edge, count + 1.f, count);
+		T flip = 0.f;
+		if (countMode == COUNT_UP)
+			flip = edge & (count == N);
+		count = simd::ifelse(edge & (count >= N), 0.f, count);
+		if (countMode == COUNT_DN)
+			flip = edge & (count == 0.f);
+		phase = phase ^ flip;
+		if (changeMode == CHANGE_AT_SUB_CYCLE)
+			N = simd::ifelse(flip & phase, nextN, N);
+
+		// both modes flip between 0 and N - 1, the inverse of the forward step. Backwards,
+		// a sub cycle starts as the phase goes low and the count leaves 0
+		T backFlip = back & (count == 0.f);
+		phase = phase ^ backFlip;
+		if (changeMode == CHANGE_AT_SUB_CYCLE)
+			N = simd::ifelse(backFlip & ~phase, nextN, N);
+		count = simd::ifelse(back, count - 1.f, count);
+		count = simd::ifelse(back & (count < 0.f), N - 1.f, count);
+
+		return phase;
+	}
+
+	// Count only the clock's leading edges, for dividing an external clock. Returns the
+	// lanes where a group of N clocks starts, the first clock after a reset starts one.
+	// count stays at 0 until the group's second clock
+	ALWAYS_INLINE T processBeats(T clk) {
+		gate.set(clk);
+		return processBeats(gate);
+	}
+
+	ALWAYS_INLINE T processBeats(const TGateProcessor<T>& clk) {
+		T edge = clk.leadingEdge();
+
+		// every clock is a master cycle here
+		if (changeMode == CHANGE_AT_MASTER_CYCLE)
+			takeNextN(edge);
+
+		count = simd::ifelse(edge, count + 1.f, count);
+		T beat = edge & ((count >= N) | (count == 0.f));
+		count = simd::ifelse(beat, 0.f, count);
+
+		if (changeMode == CHANGE_AT_SUB_CYCLE)
+			N = simd::ifelse(beat, nextN, N);
+
+		return beat;
+	}
+
+	// count a number of clock edges in one step, as process() would one edge at a
+	// time. clk is the clock's current value
+	void skip(T edges, T clk) {
+		// a waiting division is taken up at the first edge, whatever the change mode
+		takeNextN(edges >= 1.f);
+
+		// a count left at or over a lowered N restarts on the first edge
+		T over = (edges >= 1.f) & (count >= N);
+		T flips = simd::ifelse(over, countMode == COUNT_DN ? 1.f : 0.f, 0.f);
+		count = simd::ifelse(over, 0.f, count);
+		edges = simd::ifelse(over, edges - 1.f, edges);
+
+		// the count passes a multiple of N once per flip, count down mode flips on 0 and
+		// count up mode on N
+		T total = count + edges;
+		T wraps = simd::floor(total / N);
+		flips += countMode == COUNT_DN ? wraps - simd::floor(count / N) : wraps;
+		count = simd::ifelse(edges >= 1.f, total - wraps * N, count);
+
+		// an odd number of flips toggles the phase
+		phase = phase ^ (flips - 2.f * simd::floor(flips * 0.5f) == 1.f);
+		gate.sync(clk);
+	}
+
+	// Restart the lanes in mask at the start of a cycle, for a hard sync of the clock.
+	// A waiting division is taken up, the count goes to 0 and the phase high. Reverse
+	// lanes go to the end of the cycle before instead, as their clock runs back into it
+	ALWAYS_INLINE void restart(T mask, T reverse = 0.f) {
+		N = simd::ifelse(mask, nextN, N);
+		count = simd::ifelse(mask, simd::ifelse(reverse, N - 1.f, 0.f), count);
+		phase = simd::ifelse(mask, ~reverse, phase);
+	}
+
+	// set the division, taken up at once by lanes that have none yet or in rescaled mode
+	void setN(T in) {
+		nextN = simd::clamp(in, 1.f, maxN);
+		takeNextN(changeMode == CHANGE_RESCALED ? T::mask() : N < 1.f);
+	}
+
+	// move the lanes in mask to nextN, the count keeps its place in the half cycle. Lanes
+	// already at nextN are left as they are, so this runs per sample without a branch
+	ALWAYS_INLINE void takeNextN(T mask) {
+		T scaled = simd::fmin(simd::floor(count * nextN / N + 0.5f), nextN - 1.f);
+		count = simd::ifelse(mask & (count > 0.f) & (N >= 1.f), scaled, count);
+		N = simd::ifelse(mask, nextN, N);
+	}
+
+	// set when a new division is taken up
+	void setChangeMode(int mode) {
+		changeMode = clamp(mode, 0, DIVISION_CHANGES_LEN - 1);
+	}
+
+	// set the counter mode to up or down
+	void setCountMode(int mode) {
+		switch(mode) {
+			case COUNT_DN:
+			case COUNT_UP:
+				countMode = mode;
+				break;
+		}
+	}
+
+	// set the maximum division value - limited to 1-64
+	void setMaxN(int max) {
+		maxN = clamp(max, 1, 64);
+	}
+
+	// reset the counter
+	void reset() {
+		countMode = COUNT_DN;
+		count = -1.f;
+		N = 0.f;
+		phase = 0.f;
+		gate.reset();
+	}
+};
@@ -61,7 +61,6 @@ class GateProcessor {
 		
 		// indicates if the latest value cause a trailing edge
 		bool trailingEdge() {
-			DEBUG("IN TRAILING EDGE");
 			return prevState && !currentState;
 		}
 
@@ -83,4 +82,69 @@ class GateProcessor {
 		float light () {
 			return currentState ? 1.0f : 0.0f;	
 		}
-};
\ No newline at end of file
+};
+
+//----------------------------------------------------------------------------
+//	RootNode Plugin for VCV Rack - SIMD gate processor
+//	Processes one gate per lane of a simd vector type such as simd::float_4.
+//	States and edges are returned as lane masks.
+//----------------------------------------------------------------------------
+template <typename T>
+class TGateProcessor {
+	private:
+		// schmitt trigger state, starts high like dsp::SchmittTrigger
+		T st = T::mask();
+		T prevState = 0.f;
+		T currentState = 0.f;
+
+	public:
+		// set the gates with the given values
+		T set(T value) {
+			// standard Schmitt trigger with 0.1 and 2 Volt thresholds
+			T on = value >= 2.0f;
+			T off = value <= 0.1f;
+			st = on | (st & ~off);
+
+			prevState = currentState;
+			currentState = st;
+
+			return currentState;
+		}
+
+		// set the gates to the given values without reporting an edge
+		void sync(T value) {
+			set(value);
+			prevState = currentState;
+		}
+
+		// reset the gate processor
+		void reset() {
+			st = T::mask();
+			prevState = currentState = 0.f;
+		}
+
+		// gate high indicator
+		T high() const {
+			return currentState;
+		}
+
+		// gate low indicator
+		T low() const {
+			return ~currentState;
+		}
+
+		// indicates if the latest value cause a leading edge
+		T leadingEdge() const {
+			return currentState & ~prevState;
+		}
+
+		// indicates if the latest value cause a trailing edge
+		T trailingEdge() const {
+			return prevState & ~currentState;
+		}
+
+		// indicates if the latest value cause any edge
+		T anyEdge() const {
+			return prevState ^ currentState;
+		}
+};
@@ -0,0 +1,183 @@
+//----------------------------------------------------------------------------
+//	RootNode Plugin for VCV Rack - Audio path instrumentation
+//	Times process() calls with the CPU's cycle counter and sums them per
+//	audio path, a module defined key for the configuration the call ran in.
+//	The audio thread closes a ProcessStats record every few thousand calls
+//	or whenever the path changes, and pushes it through a single producer,
+//	single consumer ring. The UI thread drains the ring into per path
+//	totals for display and CSV export. Switching the profiler or resetting
+//	it starts a new session, and records from an older one are dropped.
+//----------------------------------------------------------------------------
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace instrument {
+
+// a free running tick count, the time stamp counter where there is one, otherwise nanoseconds
+inline uint64_t ticks() {
+#if defined(__x86_64__) || defined(__i386__)
+	return __rdtsc();
+#else
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+// Ticks per nanosecond, measured once per process against the steady clock from the
+// first call. 0 until a tenth of a second has passed, which is enough to settle it.
+// UI thread only
+inline double ticksPerNs() {
+	static const uint64_t startTicks = ticks();
+	static const std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+	static double rate = 0.0;
+	if (rate == 0.0) {
+		double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - startTime).count();
+		if (ns > 1e8)
+			rate = (ticks() - startTicks) / ns;
+	}
+	return rate;
+}
+
+} // namespace instrument
+
+// process() calls made in one audio path
+struct ProcessStats {
+	uint32_t path = 0;
+	uint64_t calls = 0;
+	uint64_t ticks = 0;
+	uint64_t worstTicks = 0;
+	// the profiler session the calls were made in
+	uint32_t session = 0;
+};
+
+// Lock-free ring for one writing and one reading thread. SIZE is a power of two, a
+// push to a full ring fails rather than overwriting what the reader has not seen
+template <typename T, int SIZE>
+struct SpscRing {
+	static_assert((SIZE & (SIZE - 1)) == 0, "SpscRing size must be a power of two");
+
+	T items[SIZE];
+	std::atomic<uint32_t> head {0};
+	std::atomic<uint32_t> tail {0};
+
+	// writer thread
+	bool push(const T& item) {
+		uint32_t h = head.load(std::memory_order_relaxed);
+		if (h - tail.load(std::memory_order_acquire) == SIZE)
+			return false;
+		items[h & (SIZE - 1)] = item;
+		head.store(h + 1, std::memory_order_release);
+		return true;
+	}
+
+	// reader thread
+	bool pop(T& item) {
+		uint32_t t = tail.load(std::memory_order_relaxed);
+		if (t == head.load(std::memory_order_acquire))
+			return false;
+		item = items[t & (SIZE - 1)];
+		tail.store(t + 1, std::memory_order_release);
+		return true;
+	}
+};
+
+struct ProcessProfiler {
+	// calls per record, about 85 ms at 48 kHz
+	static const uint64_t RECORD_CALLS = 4096;
+
+	// set from the UI thread, read once per process() call
+	std::atomic<bool> enabled {false};
+
+	// records handed over to the UI thread, and the ones lost to a full ring
+	SpscRing<ProcessStats, 256> ring;
+	std::atomic<uint32_t> dropped {0};
+
+	// bumped from the UI thread to leave the calls timed so far out of the totals
+	std::atomic<uint32_t> session {0};
+
+	// audio thread, the open record
+	ProcessStats current;
+
+	// UI thread, on switching the profiler on or off and on reset
+	void restart() {
+		session.fetch_add(1, std::memory_order_relaxed);
+		dropped.store(0, std::memory_order_relaxed);
+	}
+
+	// audio thread, add one call that took the given ticks in the given path
+	void add(uint32_t path, uint64_t ticks) {
+		// the open record from an older session is dropped rather than handed over
+		uint32_t s = session.load(std::memory_order_relaxed);
+		if (s != current.session) {
+			current = ProcessStats();
+			current.session = s;
+		}
+		else if (path != current.path || current.calls >= RECORD_CALLS)
+			flush();
+		current.path = path;
+		current.calls++;
+		current.ticks += ticks;
+		if (ticks > current.worstTicks)
+			current.worstTicks = ticks;
+	}
+
+	// audio thread, hand the open record over
+	void flush() {
+		if (current.calls > 0 && !ring.push(current))
+			dropped.fetch_add(1, std::memory_order_relaxed);
+		uint32_t s = current.session;
+		current = ProcessStats();
+		current.session = s;
+	}
+};
+
+// UI thread totals of everything drained from a profiler
+struct ProfileTotals {
+	std::map<uint32_t, ProcessStats> paths;
+	ProcessStats all;
+	uint32_t dropped = 0;
+
+	// starts measuring the tick rate if nothing has yet
+	ProfileTotals() {
+		instrument::ticksPerNs();
+	}
+
+	void clear() {
+		paths.clear();
+		all = ProcessStats();
+		dropped = 0;
+	}
+
+	void drain(ProcessProfiler& profiler) {
+		uint32_t session = profiler.session.load(std::memory_order_relaxed);
+		ProcessStats stats;
+		while (profiler.ring.pop(stats)) {
+			// still in the ring from before a restart
+			if (stats.session != session)
+				continue;
+			ProcessStats& total = paths[stats.path];
+			total.path = stats.path;
+			for (ProcessStats* t : {&total, &all}) {
+				t->calls += stats.calls;
+				t->ticks += stats.ticks;
+				t->worstTicks = std::max(t->worstTicks, stats.worstTicks);
+			}
+		}
+		dropped += profiler.dropped.exchange(0, std::memory_order_relaxed);
+	}
+
+	// false while the tick rate is still being measured, the times are not known yet
+	bool calibrated() const {
+		return instrument::ticksPerNs() > 0.0;
+	}
+
+	double nanoseconds(double ticks) const {
+		return ticks / instrument::ticksPerNs();
+	}
+};
@@ -0,0 +1,91 @@
+//----------------------------------------------------------------------------
+//	RootNode Plugin for VCV Rack - Mix bus
+//	The parts of the TOTAL mix: smoothing for the level knobs, a DC blocker
+//	and a soft clipper read from a table built once and shared. The filters
+//	and the clipper work on four channels at a time.
+//----------------------------------------------------------------------------
+#pragma once
+#include <cmath>
+#include "Utility.hpp"
+
+// the mix never leaves +-11.2 V, where it was always clipped
+static const float MIX_LIMIT = 11.2f;
+
+// One-pole smoothing of gains towards their targets, once per host sample. A gain
+// within -80 dB of its target is set to it, so a level turned down reaches exactly
+// zero and its VCO or sub can be skipped. returns true once every gain is at its target
+inline bool smoothGains(float* gains, const float* targets, int count, float coeff) {
+	bool settled = true;
+	for (int i = 0; i < count; i++) {
+		float d = targets[i] - gains[i];
+		if (std::fabs(d) < 1e-4f) {
+			gains[i] = targets[i];
+		}
+		else {
+			gains[i] += coeff * d;
+			settled = false;
+		}
+	}
+	return settled;
+}
+
+// first order high pass, y = x - x[-1] + r y[-1]
+template <typename T>
+struct DcBlocker {
+	T x1 = 0.f;
+	T y1 = 0.f;
+
+	// r for a cutoff in Hz
+	static float coefficient(float cutoff, float sampleTime) {
+		return std::exp(-2.f * (float) M_PI * cutoff * sampleTime);
+	}
+
+	void reset() {
+		x1 = 0.f;
+		y1 = 0.f;
+	}
+
+	ALWAYS_INLINE T process(T x, float r) {
+		T y = x - x1 + r * y1;
+		x1 = x;
+		y1 = y;
+		return y;
+	}
+};
+
+// The soft clipper passes the mix unchanged up to the knee, then bends it into the
+// limit, knee + (limit - knee) tanh((|x| - knee) / (limit - knee)), with no step in
+// slope. Tabulated for |x| up to the range, past which it is the limit to float
+// precision. Linear interpolation is within 0.1 mV of the curve
+static const float SOFT_CLIP_KNEE = 6.f;
+static const float SOFT_CLIP_RANGE = 64.f;
+static const int SOFT_CLIP_SIZE = 1024;
+
+struct SoftClipTable {
+	// one more than the size, so the last step interpolates to the range
+	float samples[SOFT_CLIP_SIZE + 1];
+
+	SoftClipTable() {
+		double bend = MIX_LIMIT - SOFT_CLIP_KNEE;
+		for (int i = 0; i <= SOFT_CLIP_SIZE; i++) {
+			double x = (double) i * SOFT_CLIP_RANGE / SOFT_CLIP_SIZE;
+			samples[i] = (float) (x < SOFT_CLIP_KNEE ? x : SOFT_CLIP_KNEE + bend * std::tanh((x - SOFT_CLIP_KNEE) / bend));
+		}
+	}
+};
+
+static const SoftClipTable softClipTable;
+
+// four lanes gathered into whole vectors, as readWavetable does
+inline simd::float_4 softClip(simd::float_4 x) {
+	simd::float_4 pos = simd::fmin(simd::fabs(x) * (SOFT_CLIP_SIZE / SOFT_CLIP_RANGE), (float) SOFT_CLIP_SIZE);
+	simd::float_4 index = simd::fmin(simd::floor(pos), SOFT_CLIP_SIZE - 1.f);
+	simd::float_4 frac = pos - index;
+	simd::int32_4 i = simd::int32_4(index);
+
+	const float* t = softClipTable.samples;
+	simd::float_4 a(t[i[0]], t[i[1]], t[i[2]], t[i[3]]);
+	simd::float_4 b(t[i[0] + 1], t[i[1] + 1], t[i[2] + 1], t[i[3] + 1]);
+	simd::float_4 y = a + frac * (b - a);
+	return simd::ifelse(x < 0.f, -y, y);
+}
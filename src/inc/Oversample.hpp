@@ -0,0 +1,123 @@
+//----------------------------------------------------------------------------
+//	RootNode Plugin for VCV Rack - Polyphase decimator
+//	Brings an oversampled signal back to the host rate with a windowed sinc
+//	FIR split into one branch per input phase, so only the kept output
+//	samples are computed. One voice per lane of a simd vector type such as
+//	simd::float_4.
+//----------------------------------------------------------------------------
+#pragma once
+#include <cmath>
+#include <cstring>
+
+// FIR taps for each branch, a multiple of 4. The full filter is
+// MAX_OVERSAMPLE * TAPS_PER_PHASE long at the highest factor
+static const int MAX_OVERSAMPLE = 8;
+static const int DECIMATOR_TAPS_PER_PHASE = 24;
+
+// Kaiser windowed sinc lowpass for each oversampling factor, split into polyphase
+// branches. Flat to 18 kHz and -0.6 dB at 20 kHz at a 48 kHz host rate, and down by
+// over 70 dB from 28 kHz, so little aliases below 20 kHz. Built once, shared by
+// every decimator.
+struct DecimatorFilters {
+	// phases[factor][p][i] is tap i of branch p, reversed so a branch is a forward dot product
+	float phases[MAX_OVERSAMPLE + 1][MAX_OVERSAMPLE][DECIMATOR_TAPS_PER_PHASE] = {};
+
+	DecimatorFilters() {
+		for (int factor = 2; factor <= MAX_OVERSAMPLE; factor *= 2)
+			build(factor);
+	}
+
+	// zeroth order modified Bessel function of the first kind, for the Kaiser window
+	static double besselI0(double x) {
+		double sum = 1.0;
+		double term = 1.0;
+		for (int k = 1; k < 32; k++) {
+			term *= (x / (2 * k)) * (x / (2 * k));
+			sum += term;
+		}
+		return sum;
+	}
+
+	void build(int factor) {
+		const int length = factor * DECIMATOR_TAPS_PER_PHASE;
+		// cut off a little under the host Nyquist frequency
+		const double cutoff = 0.47 / factor;
+		const double beta = 7.0;
+		double taps[MAX_OVERSAMPLE * DECIMATOR_TAPS_PER_PHASE];
+		double sum = 0.0;
+
+		for (int k = 0; k < length; k++) {
+			double x = k - (length - 1) / 2.0;
+			double sinc = x == 0.0 ? 1.0 : std::sin(2.0 * M_PI * cutoff * x) / (2.0 * M_PI * cutoff * x);
+			double r = 2.0 * k / (length - 1) - 1.0;
+			double window = besselI0(beta * std::sqrt(1.0 - r * r)) / besselI0(beta);
+			taps[k] = sinc * window;
+			sum += taps[k];
+		}
+
+		// tap k = i * factor + p belongs to branch p, at delay i
+		for (int p = 0; p < factor; p++) {
+			for (int i = 0; i < DECIMATOR_TAPS_PER_PHASE; i++)
+				phases[factor][p][DECIMATOR_TAPS_PER_PHASE - 1 - i] = (float) (taps[i * factor + p] / sum);
+		}
+	}
+};
+
+static const DecimatorFilters decimatorFilters;
+
+template <typename T>
+struct PolyphaseDecimator {
+	int factor = 1;
+
+	// input sample index within the current output frame
+	int index = 0;
+
+	// each branch's history, written twice so the newest taps are always contiguous
+	int pos = 0;
+	T history[MAX_OVERSAMPLE][2 * DECIMATOR_TAPS_PER_PHASE];
+
+	PolyphaseDecimator() {
+		reset();
+	}
+
+	void setFactor(int f) {
+		factor = f;
+		reset();
+	}
+
+	void reset() {
+		index = 0;
+		pos = 0;
+		std::memset(history, 0, sizeof(history));
+	}
+
+	// push the next input sample, factor samples make up one output frame
+	void push(T x) {
+		// the first sample of a frame is the oldest, it feeds the last branch
+		T* branch = history[factor - 1 - index];
+		branch[pos] = x;
+		branch[pos + DECIMATOR_TAPS_PER_PHASE] = x;
+		index++;
+	}
+
+	// output for the frame just pushed
+	T process() {
+		// four running sums, so the adds don't wait on each other
+		T sums[4] = {0.f, 0.f, 0.f, 0.f};
+		for (int p = 0; p < factor; p++) {
+			const float* h = decimatorFilters.phases[factor][p];
+			const T* x = &history[p][pos + 1];
+			for (int i = 0; i < DECIMATOR_TAPS_PER_PHASE; i += 4) {
+				sums[0] += x[i] * h[i];
+				sums[1] += x[i + 1] * h[i + 1];
+				sums[2] += x[i + 2] * h[i + 2];
+				sums[3] += x[i + 3] * h[i + 3];
+			}
+		}
+		T out = (sums[0] + sums[1]) + (sums[2] + sums[3]);
+
+		index = 0;
+		pos = (pos + 1) % DECIMATOR_TAPS_PER_PHASE;
+		return out;
+	}
+};
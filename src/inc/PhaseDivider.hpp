@@ -0,0 +1,149 @@
+//----------------------------------------------------------------------------
+//	RootNode Plugin for VCV Rack - Phase Divider
+//	Derives a sub oscillator's phase from its master's phase accumulator,
+//	one voice per lane of a simd vector type such as simd::float_4.
+//	The sub phase is (completed master cycles + master phase) / N, so the
+//	sub edges land exactly on the master's wraps with no edge detection.
+//	A new division from setN() waits in nextN until the boundary named by
+//	the change mode, and the cycle count moves to the nearest place.
+//----------------------------------------------------------------------------
+#pragma once
+#include "Utility.hpp"
+
+template <typename T>
+struct PhaseDivider {
+	// master cycles completed in the current sub cycle
+	T cycle = 0.f;
+	T N = 0.f;
+	T nextN = 0.f;
+	float maxN = 20.f;
+	int changeMode = CHANGE_AT_SUB_CYCLE;
+
+	// sub phase in [0, 1)
+	T phase = 0.f;
+
+	// sub square edges in the latest frame and their positions relative to it
+	T rise = 0.f;
+	T riseP = 0.f;
+	T fall = 0.f;
+	T fallP = 0.f;
+
+	// advance from the master's wrapped phase, its wrap mask, wrap position and phase
+	// increment. THROUGH_ZERO follows a master running backwards, counting its cycles
+	// down, rise and fall then mark sub edges met in either direction
+	template <bool THROUGH_ZERO = false>
+	ALWAYS_INLINE void process(T masterPhase, T masterWrap, T masterWrapP, T masterDelta) {
+		T oldPhase = phase;
+
+		if (THROUGH_ZERO) {
+			// a backward wrap steps back a master cycle, the sub wraps backward leaving cycle 0
+			T backward = masterDelta < 0.f;
+			T up = masterWrap & ~backward;
+			T down = masterWrap & backward;
+			cycle = simd::ifelse(up, cycle + 1.f, cycle);
+			rise = (up & (cycle >= N)) | (down & (cycle <= 0.f));
+			cycle = simd::ifelse(cycle >= N, 0.f, cycle);
+			cycle = simd::ifelse(down, simd::ifelse(cycle <= 0.f, N - 1.f, cycle - 1.f), cycle);
+		}
+		else {
+			// count master cycles, the sub wraps with the master every N cycles
+			cycle = simd::ifelse(masterWrap, cycle + 1.f, cycle);
+			rise = masterWrap & (cycle >= N);
+			cycle = simd::ifelse(cycle >= N, 0.f, cycle);
+		}
+		riseP = masterWrapP;
+
+		// a waiting division starts with the master's next cycle or the sub's, in either direction
+		if (changeMode == CHANGE_AT_MASTER_CYCLE)
+			takeNextN(masterWrap, masterPhase);
+		else if (changeMode == CHANGE_AT_SUB_CYCLE)
+			takeNextN(rise, masterPhase);
+
+		phase = (cycle + masterPhase) / N;
+
+		// the sub square falls half way through the sub cycle
+		if (THROUGH_ZERO)
+			fall = ~rise & ((oldPhase < 0.5f) ^ (phase < 0.5f));
+		else
+			fall = ~rise & (oldPhase < 0.5f) & (phase >= 0.5f);
+		fallP = (0.5f - phase) * N / masterDelta;
+	}
+
+	// advance by a number of master wraps in one step, masterPhase is the master's current phase
+	void skip(T wraps, T masterPhase) {
+		// a waiting division is taken up at the first wrap, whatever the change mode
+		takeNextN(wraps >= 1.f, phase * N - cycle);
+
+		T total = cycle + wraps;
+		cycle = total - simd::floor(total / N) * N;
+		phase = (cycle + masterPhase) / N;
+		rise = fall = 0.f;
+	}
+
+	// Restart the lanes in mask at the start of a sub cycle, for a hard sync of the
+	// master, now at masterPhase. A waiting division is taken up. Reverse lanes go to
+	// the end of the cycle before instead. The sub square steps at p, so both edge
+	// positions are set there and no edge is flagged
+	ALWAYS_INLINE void restart(T mask, T masterPhase, T p, T reverse = 0.f) {
+		N = simd::ifelse(mask, nextN, N);
+		cycle = simd::ifelse(mask, simd::ifelse(reverse, N - 1.f, 0.f), cycle);
+		phase = simd::ifelse(mask, (cycle + masterPhase) / N, phase);
+		rise = rise & ~mask;
+		fall = fall & ~mask;
+		riseP = simd::ifelse(mask, p, riseP);
+		fallP = simd::ifelse(mask, p, fallP);
+	}
+
+	// the naive sub square
+	T sqr() {
+		return simd::ifelse(phase < 0.5f, 5.f, -5.f);
+	}
+
+	// the naive sub saw
+	T saw() {
+		return 10.f * phase - 5.f;
+	}
+
+	// position of the latest sub square edge
+	T edgeP() {
+		return simd::ifelse(rise, riseP, fallP);
+	}
+
+	// set the division, taken up at once by lanes that have none yet or in rescaled mode
+	void setN(T in) {
+		nextN = simd::clamp(in, 1.f, maxN);
+		T now = changeMode == CHANGE_RESCALED ? T::mask() : N < 1.f;
+		if (!simd::movemask(now & (nextN != N)))
+			return;
+
+		// the master's phase is unchanged, so the sub phase moves to the nearest master cycle
+		T masterPhase = simd::ifelse(N < 1.f, 0.f, phase * N - cycle);
+		takeNextN(now, masterPhase);
+		phase = (cycle + masterPhase) / N;
+	}
+
+	// move the lanes in mask to nextN, with the cycle count closest to the sub phase. Lanes
+	// already at nextN keep their count, so this runs per sample without a branch
+	ALWAYS_INLINE void takeNextN(T mask, T masterPhase) {
+		T target = simd::floor((cycle + masterPhase) * nextN / N - masterPhase + 0.5f);
+		target = simd::clamp(target, 0.f, nextN - 1.f);
+		cycle = simd::ifelse(mask, simd::ifelse(N < 1.f, 0.f, target), cycle);
+		N = simd::ifelse(mask, nextN, N);
+	}
+
+	// set when a new division is taken up
+	void setChangeMode(int mode) {
+		changeMode = clamp(mode, 0, DIVISION_CHANGES_LEN - 1);
+	}
+
+	// set the maximum division value - limited to 1-64
+	void setMaxN(int max) {
+		maxN = clamp(max, 1, 64);
+	}
+
+	void reset() {
+		cycle = 0.f;
+		phase = 0.f;
+		rise = fall = 0.f;
+	}
+};
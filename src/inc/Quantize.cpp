@@ -1,96 +1,113 @@
 #include <cmath>
-#include <vector>
 #include <algorithm>
+#include <atomic>
 
 const double A4_FREQUENCY = 440.0;
-const int A4_MIDI_NOTE = 69; 
 const double C4_FREQUENCY = 261.626;
 
-// converts freq in hertz to midi note for 12 tone system
-double frequencyToMidi12(double frequency) {
-    return A4_MIDI_NOTE + 12.0 * std::log2(frequency / A4_FREQUENCY);
-}
-
-// converts midi note to frequency value for 12 tone system
-double midiToFrequency12(double midiNote) {
-    return A4_FREQUENCY * std::pow(2.0, (midiNote - A4_MIDI_NOTE) / 12.0);
-}
-
-// converts freq in hertz to midi note for 8 tone system
-double frequencyToMidi8(double frequency) {
-    return A4_MIDI_NOTE + 8.0 * std::log2(frequency / A4_FREQUENCY);
-}
-
-// converts midi note to frequency value for 8 tone system
-double midiToFrequency8(double midiNote) {
-    return A4_FREQUENCY * std::pow(2.0, (midiNote - A4_MIDI_NOTE) / 8.0);
-}
-
-double quantize12ET(double frequency) {
-    double midiNote = frequencyToMidi12(frequency);
-    double roundedMidi = std::round(midiNote);
-    return midiToFrequency12(roundedMidi);
-}
-
-double quantize8ET(double frequency) {
-	double midiNote = frequencyToMidi8(frequency);
-	double roundedMidi = std::round(midiNote);
-	return midiToFrequency8(roundedMidi);
-
-}
-
-double quantize12JI(double frequency) {
-	float ratios[13] = { 1.f / 1.f, 16.f / 15.f, 9.f / 8.f, 6.f / 5.f, 5.f / 4.f, 4.f / 3.f,
-									45.f / 32.f, 3.f / 2.f, 8.f / 5.f, 5.f / 3.f, 9.f / 5.f, 15.f / 8.f,
-									2.f / 1.f};
-	double relativeFrequency = frequency / C4_FREQUENCY;
-	double octaveFactor = 1.f;
-
-    while (relativeFrequency >= 2.0) {
-        relativeFrequency /= 2.0;
-		octaveFactor *= 2.f;
-    }
-
-    // Find the closest ratio
-    double minError = std::numeric_limits<double>::max();
-    double closestRatio = 0.0;
-    std::string closestDegree;
-    for (size_t i = 0; i < sizeof(ratios); ++i) {
-        double error = std::abs(relativeFrequency - ratios[i]);
-        if (error < minError) {
-            minError = error;
-            closestRatio = ratios[i];
-        }
-    }
-
-    // Calculate the frequency in just intonation
-    return C4_FREQUENCY * closestRatio * octaveFactor;
-}
-
-double quantize8JI(double frequency) {
-	float ratios[8] = { 1.f / 1.f, 9.f / 8.f, 5.f / 4.f, 4.f / 3.f,
-							3.f / 2.f, 5.f / 3.f, 15.f / 8.f,
-							2.f / 1.f};
-	double relativeFrequency = frequency / C4_FREQUENCY;
-	double octaveFactor = 1.f;
-
-    while (relativeFrequency >= 2.0) {
-        relativeFrequency /= 2.0;
-		octaveFactor *= 2.f;
-    }
-
-    // Find the closest ratio
-    double minError = std::numeric_limits<double>::max();
-    double closestRatio = 0.0;
-    std::string closestDegree;
-    for (size_t i = 0; i < sizeof(ratios); ++i) {
-        double error = std::abs(relativeFrequency - ratios[i]);
-        if (error < minError) {
-            minError = error;
-            closestRatio = ratios[i];
-        }
-    }
-
-    // Calculate the frequency in just intonation
-    return C4_FREQUENCY * closestRatio * octaveFactor;
-}
\ No newline at end of file
+// range of frequencies covered by a scale table, inputs outside it snap to the end notes
+const double SCALE_MIN_FREQUENCY = 1.0;
+const double SCALE_MAX_FREQUENCY = 32000.0;
+
+// A scale laid out as every note frequency in the audio range, in ascending order.
+// thresholds[i] is the geometric mean of notes[i] and notes[i + 1], which is the
+// midpoint between them in the log domain, so nearest-note quantizing becomes a
+// binary search on the raw frequency with no log2 or pow per call.
+struct ScaleTable {
+	static const int MAX_NOTES = 2048;
+
+	// unique per build, so a quantizer can tell tables apart even when one reuses
+	// the memory of another
+	unsigned id = 0;
+	int size = 0;
+	float notes[MAX_NOTES];
+	float thresholds[MAX_NOTES];
+
+	// fill the table from ratios within one period, ratios must be ascending in [1, period)
+	void build(const double* ratios, int count, double period, double reference) {
+		static std::atomic<unsigned> builds {0};
+		id = ++builds;
+		size = 0;
+
+		// walk down to the first period that starts below the covered range
+		double base = reference;
+		while (base > SCALE_MIN_FREQUENCY)
+			base /= period;
+
+		for (; base <= SCALE_MAX_FREQUENCY && size < MAX_NOTES; base *= period) {
+			for (int i = 0; i < count && size < MAX_NOTES; i++) {
+				double frequency = base * ratios[i];
+				if (frequency >= SCALE_MIN_FREQUENCY && frequency <= SCALE_MAX_FREQUENCY)
+					notes[size++] = (float) frequency;
+			}
+		}
+
+		for (int i = 0; i + 1 < size; i++)
+			thresholds[i] = (float) std::sqrt((double) notes[i] * notes[i + 1]);
+	}
+
+	// fill the table with an equal tempered scale of the given number of steps per octave
+	void buildEqual(int steps, double reference) {
+		double ratios[MAX_NOTES];
+		for (int i = 0; i < steps; i++)
+			ratios[i] = std::pow(2.0, (double) i / steps);
+
+		build(ratios, steps, 2.0, reference);
+	}
+
+	// returns the note nearest to the given frequency in the log domain
+	float quantize(float frequency) const {
+		if (size == 0)
+			return frequency;
+
+		int index = std::upper_bound(thresholds, thresholds + size - 1, frequency) - thresholds;
+		return notes[index];
+	}
+};
+
+// the built in tunings, indexed by the quantize mode
+struct BuiltinScales {
+	ScaleTable tables[5];
+
+	BuiltinScales() {
+		const double ratios12JI[12] = { 1.0 / 1.0, 16.0 / 15.0, 9.0 / 8.0, 6.0 / 5.0, 5.0 / 4.0, 4.0 / 3.0,
+										45.0 / 32.0, 3.0 / 2.0, 8.0 / 5.0, 5.0 / 3.0, 9.0 / 5.0, 15.0 / 8.0 };
+		const double ratios8JI[7] = { 1.0 / 1.0, 9.0 / 8.0, 5.0 / 4.0, 4.0 / 3.0,
+										3.0 / 2.0, 5.0 / 3.0, 15.0 / 8.0 };
+
+		tables[1].buildEqual(12, A4_FREQUENCY);
+		tables[2].buildEqual(8, A4_FREQUENCY);
+		tables[3].build(ratios12JI, 12, 2.0, C4_FREQUENCY);
+		tables[4].build(ratios8JI, 7, 2.0, C4_FREQUENCY);
+	}
+
+	// returns the table for a quantize mode, or null when quantizing is off
+	const ScaleTable* get(int mode) const {
+		if (mode <= 0 || mode >= 5)
+			return nullptr;
+		return &tables[mode];
+	}
+};
+
+static const BuiltinScales builtinScales;
+
+// Per voice quantizer state. Remembers the last input and output so a steady
+// pitch costs a single comparison.
+struct Quantizer {
+	unsigned tableId = 0;
+	float lastIn = -1.f;
+	float lastOut = 0.f;
+
+	float process(const ScaleTable* scale, float frequency) {
+		if (!scale)
+			return frequency;
+
+		if (scale->id != tableId || frequency != lastIn) {
+			tableId = scale->id;
+			lastIn = frequency;
+			lastOut = scale->quantize(frequency);
+		}
+
+		return lastOut;
+	}
+};
@@ -0,0 +1,75 @@
+//----------------------------------------------------------------------------
+//	RootNode Plugin for VCV Rack - Real-time safety guard
+//	Built with RT_GUARD defined, a Scope marks the calling thread as inside
+//	process(). Logging from a guarded scope, or from a malloc/free hook that
+//	calls rtguard::check(), aborts with the offending call's name.
+//	Without RT_GUARD everything here compiles away.
+//----------------------------------------------------------------------------
+#pragma once
+
+#ifdef RT_GUARD
+#include <cstdio>
+#include <cstdlib>
+
+namespace rtguard {
+
+// guarded scopes entered on this thread
+inline int& depth() {
+	static thread_local int d = 0;
+	return d;
+}
+
+inline bool active() {
+	return depth() > 0;
+}
+
+// report and abort, the guard is dropped first so the report itself may allocate
+[[noreturn]] inline void violation(const char* what) {
+	depth() = 0;
+	std::fprintf(stderr, "RT_GUARD: %s called inside process()\n", what);
+	std::fflush(stderr);
+	std::abort();
+}
+
+inline void check(const char* what) {
+	if (active())
+		violation(what);
+}
+
+struct Scope {
+	Scope() {
+		depth()++;
+	}
+
+	~Scope() {
+		depth()--;
+	}
+};
+
+} // namespace rtguard
+
+// route the Rack log macros through the guard
+#undef DEBUG
+#undef INFO
+#undef WARN
+#define DEBUG(format, ...) (rtguard::check("DEBUG"), rack::logger::log(rack::logger::DEBUG_LEVEL, __FILE__, __LINE__, __FUNCTION__, format, ##__VA_ARGS__))
+#define INFO(format, ...) (rtguard::check("INFO"), rack::logger::log(rack::logger::INFO_LEVEL, __FILE__, __LINE__, __FUNCTION__, format, ##__VA_ARGS__))
+#define WARN(format, ...) (rtguard::check("WARN"), rack::logger::log(rack::logger::WARN_LEVEL, __FILE__, __LINE__, __FUNCTION__, format, ##__VA_ARGS__))
+
+#else
+
+namespace rtguard {
+
+inline bool active() {
+	return false;
+}
+
+inline void check(const char* what) {}
+
+struct Scope {
+	Scope() {}
+};
+
+} // namespace rtguard
+
+#endif
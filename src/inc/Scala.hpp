@@ -0,0 +1,325 @@
+//----------------------------------------------------------------------------
+//	RootNode Plugin for VCV Rack - Scala tunings
+//	Parses Scala scale (.scl) and keyboard mapping (.kbm) files into a
+//	ScaleTable, and hands finished tables to the audio thread through an
+//	atomic pointer. Everything except ScaleSlot::acquire()/release() is for
+//	the UI thread: it allocates and may take a while.
+//	File formats: https://www.huygens-fokker.org/scala/scl_format.html
+//----------------------------------------------------------------------------
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+// a parsed .scl file, ratios[i] is degree i + 1, the last ratio is the period
+struct ScalaScale {
+	std::string description;
+	std::vector<double> ratios;
+
+	int size() const {
+		return (int) ratios.size();
+	}
+
+	double period() const {
+		return ratios.back();
+	}
+
+	// ratio of any scale degree to degree 0, wrapping through the period
+	double degreeRatio(int degree) const {
+		int n = size();
+		int octave = degree >= 0 ? degree / n : -((n - 1 - degree) / n);
+		int step = degree - octave * n;
+		double ratio = step == 0 ? 1.0 : ratios[step - 1];
+		return ratio * std::pow(period(), octave);
+	}
+};
+
+// a parsed .kbm file, map[i] is the scale degree for key middleNote + i, -1 when unmapped.
+// an empty map is a linear mapping. The first/last note range is kept but not enforced,
+// the quantizer always covers the whole audio range.
+struct ScalaMapping {
+	int mapSize = 0;
+	int firstNote = 0;
+	int lastNote = 127;
+	int middleNote = 60;
+	int referenceNote = 60;
+	double referenceFrequency = C4_FREQUENCY;
+	int octaveDegree = 0;
+	std::vector<int> map;
+};
+
+namespace scala {
+
+// the meaningful lines of a Scala file, with comments and line endings removed
+inline std::vector<std::string> readLines(const std::string& text) {
+	std::vector<std::string> lines;
+	std::istringstream stream(text);
+	std::string line;
+	while (std::getline(stream, line)) {
+		if (!line.empty() && line.back() == '\r')
+			line.pop_back();
+		if (!line.empty() && line[0] == '!')
+			continue;
+		lines.push_back(line);
+	}
+	return lines;
+}
+
+// the first whitespace separated token of a line
+inline std::string firstToken(const std::string& line) {
+	std::istringstream stream(line);
+	std::string token;
+	stream >> token;
+	return token;
+}
+
+inline bool parseInt(const std::string& line, int& value) {
+	std::string token = firstToken(line);
+	char* end = nullptr;
+	long parsed = std::strtol(token.c_str(), &end, 10);
+	if (token.empty() || *end != '\0')
+		return false;
+	value = (int) parsed;
+	return true;
+}
+
+// a pitch line is cents when it contains a period, otherwise a ratio or a whole number
+inline bool parsePitch(const std::string& line, double& ratio) {
+	std::string token = firstToken(line);
+	if (token.empty())
+		return false;
+
+	char* end = nullptr;
+	if (token.find('.') != std::string::npos) {
+		double cents = std::strtod(token.c_str(), &end);
+		if (*end != '\0')
+			return false;
+		ratio = std::pow(2.0, cents / 1200.0);
+		return true;
+	}
+
+	size_t slash = token.find('/');
+	double numerator = std::strtod(token.substr(0, slash).c_str(), &end);
+	if (*end != '\0')
+		return false;
+	double denominator = 1.0;
+	if (slash != std::string::npos) {
+		denominator = std::strtod(token.substr(slash + 1).c_str(), &end);
+		if (*end != '\0')
+			return false;
+	}
+	if (numerator <= 0.0 || denominator <= 0.0)
+		return false;
+	ratio = numerator / denominator;
+	return true;
+}
+
+} // namespace scala
+
+// returns false with error set when the text is not a usable scale
+inline bool parseScalaScale(const std::string& text, ScalaScale& scale, std::string& error) {
+	std::vector<std::string> lines = scala::readLines(text);
+	scale = ScalaScale();
+
+	if (lines.size() < 2) {
+		error = "missing the description or note count";
+		return false;
+	}
+	scale.description = lines[0];
+
+	int count = 0;
+	if (!scala::parseInt(lines[1], count) || count < 1) {
+		error = "invalid note count";
+		return false;
+	}
+
+	for (size_t i = 2; i < lines.size() && scale.size() < count; i++) {
+		if (scala::firstToken(lines[i]).empty())
+			continue;
+		double ratio = 0.0;
+		if (!scala::parsePitch(lines[i], ratio)) {
+			error = "invalid pitch '" + scala::firstToken(lines[i]) + "'";
+			return false;
+		}
+		scale.ratios.push_back(ratio);
+	}
+
+	if (scale.size() < count) {
+		error = "fewer notes than the note count";
+		return false;
+	}
+	if (scale.period() <= 1.0) {
+		error = "the period must be above 1/1";
+		return false;
+	}
+	return true;
+}
+
+// returns false with error set when the text is not a usable keyboard mapping
+inline bool parseScalaMapping(const std::string& text, ScalaMapping& mapping, std::string& error) {
+	std::vector<std::string> lines = scala::readLines(text);
+	mapping = ScalaMapping();
+
+	// skip blank lines, the header fields are the first seven values
+	std::vector<std::string> values;
+	for (const std::string& line : lines) {
+		if (!scala::firstToken(line).empty())
+			values.push_back(scala::firstToken(line));
+	}
+
+	if (values.size() < 7) {
+		error = "missing header fields";
+		return false;
+	}
+
+	int* fields[] = {&mapping.mapSize, &mapping.firstNote, &mapping.lastNote, &mapping.middleNote, &mapping.referenceNote};
+	for (int i = 0; i < 5; i++) {
+		if (!scala::parseInt(values[i], *fields[i])) {
+			error = "invalid header field '" + values[i] + "'";
+			return false;
+		}
+	}
+
+	char* end = nullptr;
+	mapping.referenceFrequency = std::strtod(values[5].c_str(), &end);
+	if (*end != '\0' || mapping.referenceFrequency <= 0.0) {
+		error = "invalid reference frequency";
+		return false;
+	}
+	if (!scala::parseInt(values[6], mapping.octaveDegree) || mapping.mapSize < 0 || mapping.mapSize > ScaleTable::MAX_NOTES) {
+		error = "invalid map size or octave degree";
+		return false;
+	}
+
+	// missing entries are unmapped keys
+	for (int i = 0; i < mapping.mapSize; i++) {
+		int degree = -1;
+		size_t index = 7 + i;
+		if (index < values.size() && values[index] != "x" && values[index] != "X") {
+			if (!scala::parseInt(values[index], degree) || degree < 0) {
+				error = "invalid mapping entry '" + values[index] + "'";
+				return false;
+			}
+		}
+		mapping.map.push_back(degree);
+	}
+	return true;
+}
+
+// Fill a table with every note the mapping reaches, in the audio range. Without a
+// mapping, degree 0 sits on C4 and every degree is used.
+inline bool buildScalaTable(ScaleTable& table, const ScalaScale& scale, const ScalaMapping* mapping, std::string& error) {
+	std::vector<double> ratios;
+	double period = scale.period();
+	double reference = C4_FREQUENCY;
+
+	if (!mapping || mapping->mapSize == 0) {
+		ratios.push_back(1.0);
+		for (int i = 0; i + 1 < scale.size(); i++)
+			ratios.push_back(scale.ratios[i]);
+
+		if (mapping) {
+			int key = mapping->referenceNote - mapping->middleNote;
+			reference = mapping->referenceFrequency / scale.degreeRatio(key);
+		}
+	}
+	else {
+		// the mapping repeats every mapSize keys, rising by the octave degree each time
+		int size = mapping->mapSize;
+		period = scale.degreeRatio(mapping->octaveDegree);
+		if (period <= 1.0) {
+			error = "the mapping's octave degree must be above 1/1";
+			return false;
+		}
+
+		int key = mapping->referenceNote - mapping->middleNote;
+		int octave = key >= 0 ? key / size : -((size - 1 - key) / size);
+		int degree = mapping->map[key - octave * size];
+		if (degree < 0) {
+			error = "the reference note is unmapped";
+			return false;
+		}
+		reference = mapping->referenceFrequency / (scale.degreeRatio(degree) * std::pow(period, octave));
+
+		for (int d : mapping->map) {
+			if (d >= 0)
+				ratios.push_back(scale.degreeRatio(d));
+		}
+	}
+
+	// the table needs ascending, distinct ratios within one period
+	for (double& ratio : ratios) {
+		while (ratio >= period * (1.0 - 1e-9))
+			ratio /= period;
+		while (ratio < 1.0 - 1e-9)
+			ratio *= period;
+	}
+	std::sort(ratios.begin(), ratios.end());
+	std::vector<double> distinct;
+	for (double ratio : ratios) {
+		if (distinct.empty() || ratio > distinct.back() * (1.0 + 1e-9))
+			distinct.push_back(ratio);
+	}
+	if (distinct.empty()) {
+		error = "no mapped notes";
+		return false;
+	}
+
+	table.build(distinct.data(), std::min((int) distinct.size(), (int) ScaleTable::MAX_NOTES), period, reference);
+	return true;
+}
+
+// Hands tables built on the UI thread to the audio thread. The audio thread loads the
+// pointer in acquire() and bumps the epoch in release() once it is done with it. A
+// replaced table is only freed by collect() after the epoch has moved, so the audio
+// thread never locks, allocates or frees.
+struct ScaleSlot {
+	std::atomic<ScaleTable*> table {nullptr};
+	std::atomic<uint32_t> epoch {0};
+
+	// replaced tables and the epoch they were replaced at, UI thread only
+	std::vector<std::pair<ScaleTable*, uint32_t>> retired;
+
+	~ScaleSlot() {
+		delete table.load();
+		for (auto& r : retired)
+			delete r.first;
+	}
+
+	// audio thread, the table stays valid until release()
+	const ScaleTable* acquire() const {
+		return table.load(std::memory_order_acquire);
+	}
+
+	void release() {
+		epoch.fetch_add(1, std::memory_order_release);
+	}
+
+	// UI thread, takes ownership of next, which may be null
+	void publish(ScaleTable* next) {
+		ScaleTable* old = table.exchange(next);
+		if (old)
+			retired.push_back(std::make_pair(old, epoch.load()));
+		collect();
+	}
+
+	// UI thread, frees the tables the audio thread has moved past
+	void collect() {
+		uint32_t now = epoch.load();
+		for (size_t i = 0; i < retired.size();) {
+			if (retired[i].second != now) {
+				delete retired[i].first;
+				retired[i] = retired.back();
+				retired.pop_back();
+			}
+			else {
+				i++;
+			}
+		}
+	}
+};
@@ -0,0 +1,94 @@
+//----------------------------------------------------------------------------
+//	RootNode Plugin for VCV Rack - Scope
+//	The tap behind the panel display. While the display is on and on screen,
+//	the audio thread pushes the first channel of a VCO, its subs and the
+//	left mix every few samples through a single producer, single consumer
+//	ring. The UI thread drains the ring into a history of the last frames,
+//	which the display draws as triggered waveforms or as a spectrum.
+//----------------------------------------------------------------------------
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include "Instrumentation.hpp"
+
+// the traces in each frame, the shown VCO first
+enum ScopeTrace {
+	SCOPE_VCO,
+	SCOPE_SUB1,
+	SCOPE_SUB2,
+	SCOPE_TOTAL,
+	SCOPE_TRACES_LEN
+};
+
+struct ScopeFrame {
+	float values[SCOPE_TRACES_LEN];
+};
+
+struct ScopeTap {
+	// about 85 ms of frames at 48 kHz with every sample tapped, several UI frames
+	static const int RING_SIZE = 4096;
+
+	// set from the UI thread, read once per process() call
+	std::atomic<bool> enabled {false};
+	// host samples per frame and the VCO shown, set from the UI thread
+	std::atomic<int> decimation {1};
+	std::atomic<int> vco {0};
+
+	// frames handed over to the UI thread, a full ring drops the newest
+	SpscRing<ScopeFrame, RING_SIZE> ring;
+
+	// audio thread, samples since the last frame
+	int count = 0;
+
+	// audio thread, true once every decimation samples
+	bool due() {
+		if (++count < decimation.load(std::memory_order_relaxed))
+			return false;
+		count = 0;
+		return true;
+	}
+};
+
+// UI thread, the last frames drained from a tap
+struct ScopeHistory {
+	static const int SIZE = 4096;
+
+	float traces[SCOPE_TRACES_LEN][SIZE] = {};
+	// where the next frame goes, and how many frames are held
+	int head = 0;
+	int filled = 0;
+
+	void clear() {
+		head = 0;
+		filled = 0;
+	}
+
+	// takes everything the tap has pushed, returns the number of frames
+	int drain(ScopeTap& tap) {
+		int count = 0;
+		ScopeFrame frame;
+		while (tap.ring.pop(frame)) {
+			for (int t = 0; t < SCOPE_TRACES_LEN; t++)
+				traces[t][head] = frame.values[t];
+			head = (head + 1) & (SIZE - 1);
+			count++;
+		}
+		filled = std::min(filled + count, SIZE);
+		return count;
+	}
+
+	// a trace age frames before the newest
+	float at(int trace, int age) const {
+		return traces[trace][(head - 1 - age) & (SIZE - 1)];
+	}
+
+	// the age of the newest rising zero crossing in a trace at least minAge frames
+	// old, or -1 when there is none
+	int trigger(int trace, int minAge) const {
+		for (int age = minAge; age < filled - 1; age++) {
+			if (at(trace, age + 1) < 0.f && at(trace, age) >= 0.f)
+				return age;
+		}
+		return -1;
+	}
+};
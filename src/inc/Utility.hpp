@@ -7,4 +7,20 @@
 // handy macros to convert a bool to an appropriate value for output and display
 #define boolToGate(x) x ? 10.0f : 0.0f 
 #define boolToLight(x) x ? 1.0f : 0.0f 
-#define boolToAudio(x) x ? 5.0f : -5.0f
\ No newline at end of file
+#define boolToAudio(x) x ? 5.0f : -5.0f
+
+// per sample helpers called from the specialised process kernels, inlined so each
+// kernel compiles to one flat loop
+#if defined(__GNUC__)
+#define ALWAYS_INLINE inline __attribute__((always_inline))
+#else
+#define ALWAYS_INLINE inline
+#endif
+
+// when a divider takes up a new division
+enum DivisionChange {
+	CHANGE_AT_MASTER_CYCLE,
+	CHANGE_AT_SUB_CYCLE,
+	CHANGE_RESCALED,
+	DIVISION_CHANGES_LEN
+};
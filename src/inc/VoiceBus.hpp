@@ -0,0 +1,69 @@
+//----------------------------------------------------------------------------
+//	RootNode Plugin for VCV Rack - Voice bus
+//	The expander message SubharmonicGenerator publishes to the module on its
+//	right: the frequency, divisions and phases of every VCO and sub after
+//	each sample, so a companion module can follow them without cables and
+//	without working them out again from the audio.
+//----------------------------------------------------------------------------
+#pragma once
+#include <atomic>
+#include <cstdint>
+
+// "RNVB" read as a little endian word
+static const uint32_t VOICE_BUS_MAGIC = 0x42564e52;
+static const uint16_t VOICE_BUS_VERSION = 2;
+static const int VOICE_BUS_CHANNELS = 16;
+static const int VOICE_BUS_SUBS = 4;
+
+// The host keeps two of these as its right expander's producer and consumer
+// messages. Each sample it writes the producer and asks for a flip, and Rack swaps
+// the two between samples. A module on the right reads the state in place from
+//	leftExpander.module->rightExpander.consumerMessage
+// once it has checked the magic and version, with the same one sample delay as a
+// cable. Later versions only add fields at the end, and size gives the length the
+// host wrote.
+//
+// The host only publishes to a reader that asks. A reader stores the version it
+// reads in reader every time it reads, into the message it reads, and the host
+// starts publishing at its next control update. The host clears the request when
+// the module on its right changes, so any other module placed there costs nothing
+// and the VCOs are still idled while nothing is heard. Version 1 had no request.
+//
+// Arrays are by VCO, or by sub with VCO1's subs first, then by channel. Only the
+// first channels are current. In unison each copy of a voice is a channel of its
+// own, with the copies of each output channel next to each other.
+struct VoiceBusMessage {
+	uint32_t magic = VOICE_BUS_MAGIC;
+	uint16_t version = VOICE_BUS_VERSION;
+	uint16_t size = sizeof(VoiceBusMessage);
+	// the host's frame the state is from, -1 until the first sample
+	int64_t frame = -1;
+	int32_t channels = 0;
+	// SubharmonicGenerator::DividerMode
+	int32_t dividerMode = 0;
+	// Bit v is set while VCO v's output is heard, bit 2 + s while sub s is. The saw
+	// ramps only run while their output is heard
+	int32_t heard = 0;
+	// set by the reader, see above
+	std::atomic<uint32_t> reader {0};
+
+	// in Hz, with FM
+	alignas(16) float oscFreq[2][VOICE_BUS_CHANNELS];
+	// the VCO's phase, 0 to 1, its square is high below the duty cycle
+	float oscPhase[2][VOICE_BUS_CHANNELS];
+	float sawPhase[2][VOICE_BUS_CHANNELS];
+	float subN[VOICE_BUS_SUBS][VOICE_BUS_CHANNELS];
+	// master edges counted in edge counted and rhythm mode, master cycles completed in
+	// phase locked mode
+	float subCount[VOICE_BUS_SUBS][VOICE_BUS_CHANNELS];
+	// the sub's place in its cycle, 0 to 1. In rhythm mode the share of its clocks
+	float subPhase[VOICE_BUS_SUBS][VOICE_BUS_CHANNELS];
+	float subSawPhase[VOICE_BUS_SUBS][VOICE_BUS_CHANNELS];
+
+	// the request as the reader makes it
+	void requestBus() {
+		reader.store(VOICE_BUS_VERSION, std::memory_order_relaxed);
+	}
+};
+
+static_assert(sizeof(std::atomic<uint32_t>) == 4, "the reader request takes the place of an int32_t");
@@ -1,33 +1,112 @@
 //----------------------------------------------------------------------------
 //	RootNode Plugin for VCV Rack - Waveform Converter
 //	Converts a square wave to a sawtooth wave maintaining phase
+//	T is a simd vector type such as simd::float_4, one voice per lane
 //----------------------------------------------------------------------------
 #pragma once
 #include "GateProcessor.hpp"
+#include "BandLimit.hpp"
 
+template <typename T>
 class WaveformConverter {
 	private:
-		float phase = 0.f;
-		GateProcessor gate;
+		T phase = 0.f;
+		TGateProcessor<T> gate;
+		MinBlep<T> sawMinBlep;
 
 	public:
-		// converts input waveform to sawtooth wave
-		float toSaw(float value, float freq, float sampleTime) {
+		// converts input waveform to a band limited sawtooth wave, edgeP is the
+		// position of the input's edge within the current frame. THROUGH_ZERO
+		// lets a negative freq run the ramp down
+		template <bool THROUGH_ZERO = false>
+		ALWAYS_INLINE T toSaw(T value, T freq, float sampleTime, T edgeP) {
 			gate.set(value);
+			T deltaPhase = freq * sampleTime;
 
+			if (THROUGH_ZERO) {
+				// backwards, the input's falling edge is met as a rising one, the ramp
+				// restarts from the top there and wraps up through 0
+				T backward = deltaPhase < 0.f;
+				T start = simd::ifelse(backward, 1.f, 0.f);
+				T reset = simd::ifelse(backward, gate.leadingEdge(), gate.trailingEdge());
+				insertDiscontinuities(sawMinBlep, reset, edgeP, 10.f * (start - phase - (1.f + edgeP) * deltaPhase));
+				phase = simd::ifelse(reset, start - edgeP * deltaPhase, phase + deltaPhase);
 
-			if (gate.trailingEdge()) {
-				phase = 0.f;
+				T wrap = simd::ifelse(backward, phase < 0.f, phase >= 1.f);
+				insertDiscontinuities(sawMinBlep, wrap, (1.f - start - phase) / deltaPhase, simd::ifelse(backward, 10.f, -10.f));
+				phase = simd::ifelse(wrap, phase - simd::floor(phase), phase);
+
+				return 10.f * phase - 5.f + sawMinBlep.process();
 			}
 
-			// accumulate phase
-			phase += freq * sampleTime;
+			// restart the ramp on each falling edge, from the edge's sub sample position
+			T reset = gate.trailingEdge();
+			insertDiscontinuities(sawMinBlep, reset, edgeP, -10.f * (phase + (1.f + edgeP) * deltaPhase));
+			phase = simd::ifelse(reset, -edgeP * deltaPhase, phase + deltaPhase);
 
-			if (phase >= 1.0f)
-            	phase -= 1.0f;
+			// wrap when the ramp outruns its input
+			T wrap = phase >= 1.f;
+			insertDiscontinuities(sawMinBlep, wrap, (1.f - phase) / deltaPhase, T(-10.f));
+			phase -= simd::ifelse(wrap, 1.f, 0.f);
 
-			return 10.f * phase - 5.f;
+			return 10.f * phase - 5.f + sawMinBlep.process();
 		}
-	
 
-};
\ No newline at end of file
+		// follows the input as toSaw() does and returns the ramp's phase in [0, 1) with
+		// no band limiting, for a wavetable read
+		template <bool THROUGH_ZERO = false>
+		ALWAYS_INLINE T toPhase(T value, T freq, float sampleTime, T edgeP) {
+			gate.set(value);
+			T deltaPhase = freq * sampleTime;
+
+			if (THROUGH_ZERO) {
+				T backward = deltaPhase < 0.f;
+				T reset = simd::ifelse(backward, gate.leadingEdge(), gate.trailingEdge());
+				phase = simd::ifelse(reset, simd::ifelse(backward, 1.f, 0.f) - edgeP * deltaPhase, phase + deltaPhase);
+			}
+			else {
+				phase = simd::ifelse(gate.trailingEdge(), -edgeP * deltaPhase, phase + deltaPhase);
+			}
+
+			// a reset lands a little behind 0, the table wraps there
+			phase -= simd::floor(phase);
+			return phase;
+		}
+
+		// where the ramp is in its cycle, 0 to 1
+		T getPhase() const {
+			return phase;
+		}
+
+		// Hard sync, the lanes in mask jump to start at p in the current frame. Called
+		// before toSaw(), toPhase() or fromPhase() for the frame, which then ramp on from
+		// there. The jump is band limited unless the ramp is read from a wavetable
+		template <bool BAND_LIMIT = true>
+		ALWAYS_INLINE void restart(T mask, T start, T p, T deltaPhase) {
+			if (BAND_LIMIT) {
+				// where the ramp had got to as the reset came
+				T before = phase + (1.f + p) * deltaPhase;
+				before -= simd::floor(before);
+				insertDiscontinuities(sawMinBlep, mask, p, 10.f * (start - before));
+			}
+			phase = simd::ifelse(mask, start - (1.f + p) * deltaPhase, phase);
+		}
+
+		// restart the ramp at the given phase, following value without an edge
+		void resync(T value, T newPhase) {
+			gate.sync(value);
+			phase = newPhase;
+			clearMinBlep(sawMinBlep);
+		}
+
+		// band limits a sawtooth computed directly from an oscillator phase,
+		// wrapP is the position of the phase wrap within the current frame.
+		// With THROUGH_ZERO the wrap steps up in backward lanes
+		template <bool THROUGH_ZERO = false>
+		T fromPhase(T value, T wrap, T wrapP, T backward = 0.f) {
+			insertDiscontinuities(sawMinBlep, wrap, wrapP, THROUGH_ZERO ? simd::ifelse(backward, 10.f, -10.f) : T(-10.f));
+			phase = value;
+
+			return 10.f * phase - 5.f + sawMinBlep.process();
+		}
+};
@@ -0,0 +1,132 @@
+//----------------------------------------------------------------------------
+//	RootNode Plugin for VCV Rack - Mip-mapped wavetables
+//	Band limited single cycle tables for the wavetable oscillator mode, one
+//	per shape and octave, summed from their Fourier series. Built once, with
+//	the first module, and shared by every module. Read four voices at a
+//	time, each lane from the octave that keeps its harmonics under Nyquist.
+//----------------------------------------------------------------------------
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+// in morph order. Every shape's fundamental is in phase with the saw's, so a blend of
+// two never cancels it
+enum WavetableShape {
+	TABLE_TRIANGLE,
+	TABLE_SAW,
+	TABLE_SQUARE,
+	TABLE_SHAPES_LEN
+};
+
+// Level k holds harmonics 1 to WAVETABLE_HARMONICS >> k, the last a sine. Linear
+// interpolation's images are kept 80 dB down by 32 samples per harmonic, and no
+// fewer than 2048 samples for the few harmonics of the top octaves
+static const int WAVETABLE_HARMONICS = 512;
+static const int WAVETABLE_LEVELS = 10;
+static const int WAVETABLE_SIZE_LOG2 = 14;
+static const int WAVETABLE_SIZE = 1 << WAVETABLE_SIZE_LOG2;
+static const int WAVETABLE_MIN_SIZE = 2048;
+
+struct Wavetables {
+	// in volts, every level end to end. The saw ramps from -5 to 5 V over the cycle like
+	// the minBLEP saws, the square is low for the first half and the triangle falls
+	// from 0 V
+	std::vector<float> samples;
+	const float* levels[TABLE_SHAPES_LEN][WAVETABLE_LEVELS];
+
+	static int size(int level) {
+		return std::max(WAVETABLE_SIZE >> level, WAVETABLE_MIN_SIZE);
+	}
+
+	Wavetables() {
+		int total = 0;
+		for (int level = 0; level < WAVETABLE_LEVELS; level++)
+			total += size(level);
+		samples.resize(TABLE_SHAPES_LEN * total);
+
+		for (int shape = 0; shape < TABLE_SHAPES_LEN; shape++)
+			build(shape, &samples[shape * total]);
+	}
+
+	// sine coefficient of harmonic n
+	static double amplitude(int shape, int n) {
+		switch (shape) {
+			case TABLE_SAW:
+				return -10.0 / (M_PI * n);
+			case TABLE_SQUARE:
+				return n % 2 ? -20.0 / (M_PI * n) : 0.0;
+			default:
+				return n % 2 ? (n % 4 == 1 ? -40.0 : 40.0) / (M_PI * M_PI * n * n) : 0.0;
+		}
+	}
+
+	// From the sine up, each level adds the next octave of harmonics to the one above it
+	// and keeps every few samples of the sum. The levels are laid out from level 0
+	void build(int shape, float* out) {
+		std::vector<double> sine(WAVETABLE_SIZE);
+		for (int i = 0; i < WAVETABLE_SIZE; i++)
+			sine[i] = std::sin(2.0 * M_PI * i / WAVETABLE_SIZE);
+
+		float* table = out;
+		for (int level = 0; level < WAVETABLE_LEVELS; level++) {
+			levels[shape][level] = table;
+			table += size(level);
+		}
+
+		std::vector<double> sum(WAVETABLE_SIZE, 0.0);
+		int n = 1;
+		for (int level = WAVETABLE_LEVELS - 1; level >= 0; level--) {
+			for (; n <= WAVETABLE_HARMONICS >> level; n++) {
+				double a = amplitude(shape, n);
+				if (a == 0.0)
+					continue;
+				for (int i = 0; i < WAVETABLE_SIZE; i++)
+					sum[i] += a * sine[(n * i) & (WAVETABLE_SIZE - 1)];
+			}
+
+			int stride = WAVETABLE_SIZE / size(level);
+			float* table = const_cast<float*>(levels[shape][level]);
+			for (int i = 0; i < size(level); i++)
+				table[i] = (float) sum[i * stride];
+		}
+	}
+};
+
+// The tables take a few tens of ms to build, so they are built when the first module is
+// created rather than when Rack loads the plugin
+inline const Wavetables& getWavetables() {
+	static const Wavetables tables;
+	return tables;
+}
+
+// Read a shape at phases in [0, 1) with linear interpolation. Each lane reads the level
+// with the most harmonics that stay under Nyquist at its phase step per sample,
+// floor(log2(1024 * |deltaPhase|)) + 1, taken from the float's exponent bits
+inline simd::float_4 readWavetable(const Wavetables& wavetables, int shape, simd::float_4 phase, simd::float_4 deltaPhase) {
+	simd::float_4 x = simd::fabs(deltaPhase) * (2.f * WAVETABLE_HARMONICS);
+	simd::int32_4 level = (simd::int32_4::cast(x) >> 23) - 126;
+	level = level & ~(level < 0);
+	simd::int32_4 top = level > WAVETABLE_LEVELS - 1;
+	level = (level & ~top) | (simd::int32_4(WAVETABLE_LEVELS - 1) & top);
+
+	// the level's size, 2^(14 - level) made from its exponent bits, or the minimum
+	simd::float_4 size = simd::float_4::cast((simd::int32_4(127 + WAVETABLE_SIZE_LOG2) - level) << 23);
+	size = simd::fmax(size, WAVETABLE_MIN_SIZE);
+
+	simd::float_4 pos = (phase - simd::floor(phase)) * size;
+	simd::float_4 index = simd::fmin(simd::floor(pos), size - 1.f);
+	simd::float_4 frac = pos - index;
+	simd::int32_4 i = simd::int32_4(index);
+	simd::int32_4 j = simd::int32_4(simd::ifelse(index < size - 1.f, index + 1.f, 0.f));
+
+	// gathered into whole vectors, writing lanes one at a time stalls the vector read
+	const float* const* tables = wavetables.levels[shape];
+	const float* t0 = tables[level[0]];
+	const float* t1 = tables[level[1]];
+	const float* t2 = tables[level[2]];
+	const float* t3 = tables[level[3]];
+	simd::float_4 a(t0[i[0]], t1[i[1]], t2[i[2]], t3[i[3]]);
+	simd::float_4 b(t0[j[0]], t1[j[1]], t2[j[2]], t3[j[3]]);
+	return a + frac * (b - a);
+}